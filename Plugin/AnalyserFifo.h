@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    AnalyserFifo.h
+    Created: 19 Oct 2026 8:42:15am
+    Author:  John McRae
+
+    Wait-free single producer, single consumer sample FIFO that carries
+    the output from processBlock to the editor's analyser.
+
+    The audio thread is the producer and only ever copies: push() is one
+    or two memcpys (a conversion loop for double buffers) and two atomic
+    stores, and when the consumer falls behind the samples that do not
+    fit are dropped rather than waited for. While nothing is reading,
+    setActive(false), push() returns straight away, so the analyser costs
+    nothing with the editor closed.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+template <int Capacity>
+class AnalyserFifo {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+    // samples written and read so far, wrapping round; write - read is the number waiting
+    std::atomic<uint32_t> writeCount { 0 }, readCount { 0 };
+    // whether a consumer is reading, set by the consumer
+    std::atomic<bool> active { false };
+    float data[Capacity] = {};
+
+    static void copy(float* dst, const float* src, int n) { std::memcpy(dst, src, sizeof(float) * (size_t) n); }
+    static void copy(float* dst, const double* src, int n) {
+        for (int i = 0; i < n; i++)
+            dst[i] = (float) src[i];
+    }
+
+public:
+    static constexpr int capacity = Capacity;
+
+    // producer: copies up to n samples in, drops what does not fit, never blocks
+    template <typename SampleType>
+    void push(const SampleType* src, int n) {
+        if (! active.load(std::memory_order_relaxed))
+            return;
+
+        const uint32_t w = writeCount.load(std::memory_order_relaxed);
+        const uint32_t r = readCount.load(std::memory_order_acquire);
+        n = std::min(n, Capacity - (int) (w - r));
+        if (n <= 0)
+            return;
+
+        const int start = (int) (w & (Capacity - 1));
+        const int first = std::min(n, Capacity - start);
+        copy(data + start, src, first);
+        copy(data, src + first, n - first);
+        writeCount.store(w + (uint32_t) n, std::memory_order_release);
+    }
+
+    // consumer: takes up to maxSamples samples, returns how many it took
+    int pop(float* dst, int maxSamples) {
+        const uint32_t r = readCount.load(std::memory_order_relaxed);
+        const uint32_t w = writeCount.load(std::memory_order_acquire);
+        const int n = std::min(maxSamples, (int) (w - r));
+        if (n <= 0)
+            return 0;
+
+        const int start = (int) (r & (Capacity - 1));
+        const int first = std::min(n, Capacity - start);
+        copy(dst, data + start, first);
+        copy(dst + first, data, n - first);
+        readCount.store(r + (uint32_t) n, std::memory_order_release);
+        return n;
+    }
+
+    // consumer: starts or stops the producer copying, starting throws away anything stale
+    void setActive(bool shouldBeActive) {
+        if (shouldBeActive)
+            readCount.store(writeCount.load(std::memory_order_acquire), std::memory_order_release);
+        active.store(shouldBeActive, std::memory_order_release);
+    }
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+};
+
+// the FIFO between the processor and the editor's analyser, about 0.7 s at 44.1 kHz
+using OutputFifo = AnalyserFifo<32768>;
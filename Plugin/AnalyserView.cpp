@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    AnalyserView.cpp
+    Created: 19 Oct 2026 9:20:44am
+    Author:  John McRae
+
+  ==============================================================================
+*/
+
+#include "AnalyserView.h"
+
+namespace
+{
+    // spectrum range shown, in Hz and dB
+    const float minFrequency = 20.0f;
+    const float minDb = -100.0f, maxDb = 0.0f;
+    // samples taken from the FIFO at a time
+    const int popSize = 4096;
+}
+
+AnalyserView::AnalyserThread::AnalyserThread(AnalyserView& owner)
+    : juce::Thread("Noise analyser"), view(owner), samples(popSize)
+{
+}
+
+void AnalyserView::AnalyserThread::run()
+{
+    while (!threadShouldExit())
+    {
+        bool changed = false;
+        while (const int n = view.fifo.pop(samples.data(), popSize))
+            changed = analyser.addSamples(samples.data(), n) || changed;
+
+        if (changed)
+        {
+            {
+                const juce::ScopedLock lock(view.resultLock);
+                view.levels = analyser.getLevelsDb();
+                view.scope = analyser.getScope();
+            }
+            view.version.fetch_add(1, std::memory_order_release);
+        }
+
+        // a spectrum comes every 1024 samples, so polling this often never falls behind
+        wait(15);
+    }
+}
+
+AnalyserView::AnalyserView(OutputFifo& fifoToRead, const juce::AudioProcessor& processorToShow)
+    : fifo(fifoToRead), processor(processorToShow),
+      levels(SpectrumAnalyser::numBins, minDb), scope(SpectrumAnalyser::scopeSize, 0.0f),
+      thread(*this)
+{
+    setOpaque(true);
+    setTooltip("Output spectrum and scope, first channel");
+
+    // start the audio thread copying, then the thread reading
+    fifo.setActive(true);
+    thread.startThread();
+    startTimerHz(30);
+}
+
+AnalyserView::~AnalyserView()
+{
+    stopTimer();
+    thread.stopThread(1000);
+    fifo.setActive(false);
+}
+
+void AnalyserView::timerCallback()
+{
+    const uint32_t latest = version.load(std::memory_order_acquire);
+    const double sampleRate = processor.getSampleRate();
+    if (latest == displayedVersion && sampleRate == displayedSampleRate)
+        return;
+
+    {
+        const juce::ScopedLock lock(resultLock);
+        displayLevels = levels;
+        displayScope = scope;
+    }
+    displayedVersion = latest;
+    displayedSampleRate = sampleRate;
+
+    updatePaths();
+    repaint();
+}
+
+void AnalyserView::resized()
+{
+    auto area = getLocalBounds().reduced(2);
+    scopeArea = area.removeFromRight(area.getWidth() / 3);
+    spectrumArea = area.withTrimmedRight(2);
+    updatePaths();
+}
+
+void AnalyserView::updatePaths()
+{
+    using namespace juce;
+
+    spectrumPath.clear();
+    scopePath.clear();
+    if (displayLevels.empty() || spectrumArea.isEmpty())
+        return;
+
+    // spectrum on a log frequency axis, one point per pixel at the loudest bin under it
+    const double sampleRate = displayedSampleRate > 0 ? displayedSampleRate : 44100.0;
+    const float nyquist = (float) sampleRate * 0.5f;
+    const float binWidth = (float) sampleRate / (float) SpectrumAnalyser::fftSize;
+    const int width = spectrumArea.getWidth();
+    const float left = (float) spectrumArea.getX(), top = (float) spectrumArea.getY();
+    const float height = (float) spectrumArea.getHeight();
+
+    int bin = jmax(1, (int) (minFrequency / binWidth));
+    for (int x = 0; x < width; ++x)
+    {
+        const float frequency = minFrequency * std::pow(nyquist / minFrequency, (float) (x + 1) / (float) width);
+        const int lastBin = jlimit(bin, SpectrumAnalyser::numBins - 1, (int) (frequency / binWidth));
+
+        float level = displayLevels[(size_t) bin];
+        for (int b = bin + 1; b <= lastBin; ++b)
+            level = jmax(level, displayLevels[(size_t) b]);
+        bin = jmin(lastBin + 1, SpectrumAnalyser::numBins - 1);
+
+        const float y = top + height * (maxDb - jlimit(minDb, maxDb, level)) / (maxDb - minDb);
+        if (x == 0)
+            spectrumPath.startNewSubPath(left, y);
+        else
+            spectrumPath.lineTo(left + (float) x, y);
+    }
+
+    // scope, full scale at the edges
+    const float scopeLeft = (float) scopeArea.getX();
+    const float scopeMiddle = (float) scopeArea.getCentreY();
+    const float scopeScale = (float) scopeArea.getHeight() * 0.5f;
+    const float step = (float) scopeArea.getWidth() / (float) (displayScope.size() - 1);
+    for (size_t i = 0; i < displayScope.size(); ++i)
+    {
+        const float y = scopeMiddle - scopeScale * jlimit(-1.0f, 1.0f, displayScope[i]);
+        if (i == 0)
+            scopePath.startNewSubPath(scopeLeft, y);
+        else
+            scopePath.lineTo(scopeLeft + step * (float) i, y);
+    }
+}
+
+void AnalyserView::paint(juce::Graphics& g)
+{
+    using namespace juce;
+
+    g.fillAll(Colours::black);
+    g.setColour(Colours::green);
+    g.drawRect(getLocalBounds(), 1);
+
+    // a faint line every 20 dB, and the scope's zero line
+    g.setColour(Colours::green.withAlpha(0.3f));
+    for (float db = maxDb - 20.0f; db > minDb; db -= 20.0f)
+        g.drawHorizontalLine(spectrumArea.getY() + (int) ((float) spectrumArea.getHeight() * (maxDb - db) / (maxDb - minDb)),
+                             (float) spectrumArea.getX(), (float) spectrumArea.getRight());
+    g.drawHorizontalLine(scopeArea.getCentreY(), (float) scopeArea.getX(), (float) scopeArea.getRight());
+    g.drawVerticalLine(scopeArea.getX() - 1, (float) scopeArea.getY(), (float) scopeArea.getBottom());
+
+    g.setColour(Colours::green);
+    g.strokePath(spectrumPath, PathStrokeType(1.0f));
+    g.strokePath(scopePath, PathStrokeType(1.0f));
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    AnalyserView.h
+    Created: 19 Oct 2026 9:20:44am
+    Author:  John McRae
+
+    Spectrum and oscilloscope of the processor's output for the editor.
+
+    The samples come from the processor's OutputFifo. A background thread
+    drains it into a SpectrumAnalyser, so the FFT and the averaging never
+    run on the audio or the message thread, and hands the results over
+    under a lock only it and the timer take. The timer redraws at 30 Hz at
+    most, and only rebuilds the cached spectrum and scope paths when the
+    thread has something new. The FIFO is switched on while the view
+    exists, so with the editor closed the audio thread copies nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+#include "AnalyserFifo.h"
+#include "SpectrumAnalyser.h"
+
+class AnalyserView : public juce::Component, public juce::SettableTooltipClient, private juce::Timer
+{
+public:
+    AnalyserView(OutputFifo& fifoToRead, const juce::AudioProcessor& processorToShow);
+    ~AnalyserView() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    // drains the FIFO and runs the analyser, everything it owns is its own apart from the results
+    class AnalyserThread : public juce::Thread
+    {
+    public:
+        AnalyserThread(AnalyserView& owner);
+        void run() override;
+
+    private:
+        AnalyserView& view;
+        SpectrumAnalyser analyser;
+        // one pop's worth of samples
+        std::vector<float> samples;
+    };
+
+    void timerCallback() override;
+    // rebuilds the cached paths from the display copies, for the current size
+    void updatePaths();
+
+    OutputFifo& fifo;
+    const juce::AudioProcessor& processor;
+
+    // the newest results, written by the analyser thread under resultLock
+    juce::CriticalSection resultLock;
+    std::vector<float> levels, scope;
+    // bumped by the analyser thread whenever the results change
+    std::atomic<uint32_t> version { 0 };
+
+    // the message thread's copies, and the version they came from
+    std::vector<float> displayLevels, displayScope;
+    uint32_t displayedVersion = 0;
+    double displayedSampleRate = 0;
+
+    juce::Path spectrumPath, scopePath;
+    juce::Rectangle<int> spectrumArea, scopeArea;
+
+    // last, so it is stopped before anything it uses goes away
+    AnalyserThread thread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyserView)
+};
@@ -0,0 +1,481 @@
+/*
+  ==============================================================================
+
+    ColouredNoise.h
+    Created: 19 Oct 2026 10:52:07am
+    Author:  John McRae
+
+    Noise of any 1/f^a power spectrum, made by shaping white noise in the
+    frequency domain, for the colours that have no generator of their own:
+        a =  2  brown          a = -1  blue
+        a =  1  pink           a = -2  violet
+        a =  0  white
+    and grey noise, which follows the inverse of the A weighting curve so
+    it sounds about equally loud at every frequency.
+
+    - Shaping -
+
+    ColouredNoiseShape holds the shaping filter, worked out whenever the
+    exponent or the sample rate changes: the magnitude response
+    (f / 1 kHz)^(-a/2) is sampled on a design FFT's grid, turned into a
+    linear phase FIR of firLength taps with a Hann window, normalised so
+    every colour comes out at about the same level, and cut into
+    partitions of partitionSize taps, each transformed into the frequency
+    domain ready to multiply by. Below 10 Hz the response is held flat,
+    and DC is removed. setColour() works it out on the filtering thread;
+    design() works it out on another, and hands it over through a triple
+    buffer the filtering thread takes it up from with acquire(), so the
+    audio thread never waits for a design or runs one while playing.
+
+    ColouredNoise filters its white noise with that FIR by uniformly
+    partitioned convolution: each partition of input is transformed once,
+    with the one before it (overlap-save), and kept in a short history,
+    and each partition of output is the sum of the last numPartitions
+    input spectra times the FIR's partitions, back through one inverse
+    FFT. Two partitions go through each transform at once, one as the real
+    part and one as the imaginary part, which works because the input and
+    the FIR are real. That is two FFTs of 512 points and 16 complex
+    multiply-adds a bin per 512 samples, done whenever the last pair's
+    output has been used up, so a stream never does more than that in one
+    block. Each stream can start its pairs at a different phase, so a bus
+    of streams spreads its pairs over the blocks rather than all filtering
+    in the same one.
+
+    - Position -
+
+    The white noise runs in WhiteNoise's counter mode and the partitions
+    sit at fixed positions in the stream, so the output only depends on
+    the seed, the phase and the sample position, as with the other
+    generators. seek() transforms the partitions the FIR reaches back over
+    and filters the pair that holds the position, nine pairs' worth of
+    FFTs. jump() only filters the pair, standing in whatever the history
+    holds for the partitions before it, and restart() does the same from
+    an empty history; both match seek() exactly once settleLength samples
+    have been generated.
+
+    Every stream shares one ColouredNoiseShape, which also holds the FFT
+    workspace, so a stream itself is just its white noise, its output and
+    its history of spectra. Nothing allocates after prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "NoiseFFT.h"
+#include "NoiseTrace.h"
+#include "WhiteNoise.h"
+
+template <typename SampleType = float>
+class ColouredNoiseShape {
+public:
+    // the design FFT the magnitude response is sampled on
+    static constexpr int designOrder = 13;
+    static constexpr int designSize = 1 << designOrder;
+    // taps of the shaping FIR
+    static constexpr int firLength = designSize / 2;
+    // samples per partition, the FIR is cut into numPartitions of them
+    static constexpr int partitionSize = 256;
+    static constexpr int numPartitions = firLength / partitionSize;
+    // each partition is filtered with an FFT of twice its size, overlap-save
+    static constexpr int convolutionOrder = 9;
+    static constexpr int convolutionSize = 1 << convolutionOrder;
+    // bins of a real signal's half spectrum, 0 to Nyquist
+    static constexpr int numBins = convolutionSize / 2 + 1;
+    // the spectra a stream keeps of its last partitions, one more than the FIR reaches back
+    static constexpr int historySize = numPartitions + 1;
+    // lowest frequency shaped, the response is held flat below it
+    static constexpr double lowestFrequency = 10.0;
+    // most that grey noise boosts the low end by, in dB
+    static constexpr double greyBoostLimit = 30.0;
+    // rms level of every colour, close to what the pink and brown generators give
+    static constexpr double outputRms = 0.2;
+
+    static_assert(2 * partitionSize == convolutionSize, "a partition and the one before fill the FFT");
+    static_assert(numPartitions % 2 == 0, "the partitions are filtered in pairs");
+
+private:
+    // one shaping filter and what it was worked out for
+    struct Filter {
+        float exponent = 1.0f;
+        bool grey = false;
+        double sampleRate = 44100.0;
+        // each partition of the FIR as a half spectrum, re[p * numBins + bin], scaled by
+        // 1 / convolutionSize for the inverse transform
+        std::vector<SampleType> re, im;
+    };
+
+    NoiseFFT<SampleType> designFft { designOrder };
+    NoiseFFT<SampleType> fft { convolutionOrder };
+    // three filters handed from the designing thread to the filtering thread without locking:
+    // the filtering thread reads front, a design is written into back and then swapped with
+    // middle, which has freshBit set until the filtering thread swaps it with front
+    Filter filters[3];
+    int front = 0, back = 1;
+    std::atomic<int> middle { 2 };
+    static constexpr int freshBit = 4;
+    // held while a design is worked out, so only one thread at a time writes back
+    std::atomic<bool> designing { false };
+    // the newest design's settings, only touched while designing is held
+    float latestExponent = 1.0f;
+    bool latestGrey = false;
+    double latestRate = 44100.0;
+    // the design's workspace, only touched while designing is held
+    std::vector<SampleType> designRe, designIm, taps;
+    // the filtering's workspace, shared by every stream that uses this shape
+    std::vector<SampleType> workRe, workIm;
+    std::vector<SampleType> input;
+    std::vector<SampleType> sumRe, sumIm;
+    std::vector<float> white;
+
+    static_assert(std::atomic<int>::is_always_lock_free && std::atomic<bool>::is_always_lock_free,
+                  "the filters are handed over without locking");
+
+    // A weighting, as a gain relative to 1 kHz
+    static double aWeighting(double f) {
+        auto curve = [] (double x) {
+            const double x2 = x * x;
+            return 12194.0 * 12194.0 * x2 * x2
+                 / ((x2 + 20.6 * 20.6) * std::sqrt((x2 + 107.7 * 107.7) * (x2 + 737.9 * 737.9)) * (x2 + 12194.0 * 12194.0));
+        };
+        return curve(f) / curve(1000.0);
+    }
+
+    // works a shaping filter out into filter, allocates nothing
+    void update(Filter& filter) {
+        const double maxGreyGain = std::pow(10.0, greyBoostLimit / 20.0);
+
+        // the magnitude response on the design grid, zero phase
+        for (int k = 0; k <= designSize / 2; k++) {
+            const double f = std::max(lowestFrequency, k * filter.sampleRate / designSize);
+            double gain = filter.grey ? std::min(maxGreyGain, 1.0 / aWeighting(f))
+                                      : std::pow(f / 1000.0, -0.5 * filter.exponent);
+            if (k == 0)
+                gain = 0.0;
+            designRe[(size_t) k] = (SampleType) gain;
+            designRe[(size_t) ((designSize - k) & (designSize - 1))] = (SampleType) gain;
+        }
+        std::fill(designIm.begin(), designIm.end(), (SampleType) 0);
+        designFft.perform(designRe.data(), designIm.data(), true);
+
+        // centre the impulse response in firLength taps under a Hann window
+        const double twoPi = 6.283185307179586;
+        double energy = 0.0;
+        for (int n = 0; n < firLength; n++) {
+            const double window = 0.5 - 0.5 * std::cos(twoPi * (n + 0.5) / firLength);
+            const double tap = designRe[(size_t) ((n - firLength / 2) & (designSize - 1))] / designSize * window;
+            taps[(size_t) n] = (SampleType) tap;
+            energy += tap * tap;
+        }
+
+        // the white noise is uniform in [-1, 1), variance 1/3
+        const double scale = energy > 0.0 ? outputRms / std::sqrt(energy / 3.0) / convolutionSize : 0.0;
+        SampleType* partRe = designRe.data();
+        SampleType* partIm = designIm.data();
+        for (int p = 0; p < numPartitions; p++) {
+            for (int n = 0; n < partitionSize; n++)
+                partRe[n] = (SampleType) (taps[(size_t) (p * partitionSize + n)] * scale);
+            std::fill(partRe + partitionSize, partRe + convolutionSize, (SampleType) 0);
+            std::fill(partIm, partIm + convolutionSize, (SampleType) 0);
+            fft.perform(partRe, partIm, false);
+            std::copy(partRe, partRe + numBins, filter.re.begin() + p * numBins);
+            std::copy(partIm, partIm + numBins, filter.im.begin() + p * numBins);
+        }
+    }
+
+    // works out the filter for the settings into back and hands it over, with designing held
+    void publish(float exponent, bool grey, double sampleRate) {
+        if (exponent == latestExponent && grey == latestGrey && sampleRate == latestRate)
+            return;
+        Filter& filter = filters[back];
+        filter.exponent = latestExponent = exponent;
+        filter.grey = latestGrey = grey;
+        filter.sampleRate = latestRate = sampleRate;
+        update(filter);
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & 3;
+    }
+
+    // holds designing, spinning while another thread has it
+    void lockDesign() {
+        while (designing.exchange(true, std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+public:
+    ColouredNoiseShape()
+        : designRe(designSize), designIm(designSize), taps(firLength), workRe(convolutionSize), workIm(convolutionSize),
+          input(3 * partitionSize), sumRe(2 * numBins), sumIm(2 * numBins), white(3 * partitionSize) {
+        for (auto& filter : filters) {
+            filter.re.assign((size_t) numPartitions * numBins, 0);
+            filter.im.assign((size_t) numPartitions * numBins, 0);
+        }
+        update(filters[front]);
+    }
+
+    // works out the shaping filter for a 1/f^a slope, or grey noise, on the calling thread and
+    // uses it from the next sample; the slope of the power spectrum is -3a dB per octave, a = 1
+    // is pink. A design FFT and a few thousand pow() calls, so while playing use design()
+    // from another thread instead. Call from the filtering thread
+    void setColour(float exponent, bool grey) {
+        lockDesign();
+        publish(exponent, grey, latestRate);
+        designing.store(false, std::memory_order_release);
+        acquire();
+    }
+    // setColour() for a new sample rate
+    void setSampleRate(double newSampleRate) {
+        if (newSampleRate <= 0.0)
+            return;
+        lockDesign();
+        publish(latestExponent, latestGrey, newSampleRate);
+        designing.store(false, std::memory_order_release);
+        acquire();
+    }
+
+    // works out the shaping filter on the calling thread, any but the filtering one, for the
+    // filtering thread to take up at its next acquire(); nothing to do if the newest design is
+    // already for these settings, and false if another thread is designing, so try again later
+    bool design(float exponent, bool grey) {
+        if (designing.exchange(true, std::memory_order_acquire))
+            return false;
+        publish(exponent, grey, latestRate);
+        designing.store(false, std::memory_order_release);
+        return true;
+    }
+
+    // takes up the newest design if there is one, wait-free, call from the filtering thread
+    void acquire() {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) != 0)
+            front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+    }
+
+    // the settings of the filter in use, on the filtering thread
+    float getExponent() const { return filters[front].exponent; }
+    bool isGrey() const { return filters[front].grey; }
+
+    // transforms partitions 2 * pair and 2 * pair + 1 of source into the history ring, each
+    // with the partition before it, and with out filters them: out gets the pair's
+    // 2 * partitionSize samples, from those spectra and the ones of the partitions before
+    void filterPair(WhiteNoise& source, uint64_t pair, SampleType* historyRe, SampleType* historyIm, SampleType* out) {
+        NOISE_TRACE_SCOPE("coloured fft");
+        constexpr int size = partitionSize;
+
+        // the three partitions the two windows cover, the one before the stream starts is silent
+        const uint64_t first = pair * 2 * size;
+        const int silent = pair > 0 ? 0 : size;
+        std::fill(input.begin(), input.begin() + silent, (SampleType) 0);
+        source.seek(first - (uint64_t) (size - silent));
+        source.generate(white.data(), 3 * size - silent);
+        for (int i = silent; i < 3 * size; i++)
+            input[(size_t) i] = (SampleType) (white[(size_t) (i - silent)] * 2.0f - 1.0f);
+
+        // both windows through one transform, the first as the real part and the second as the
+        // imaginary part, then pulled apart by their conjugate symmetry
+        std::copy(input.begin(), input.begin() + 2 * size, workRe.begin());
+        std::copy(input.begin() + size, input.end(), workIm.begin());
+        fft.perform(workRe.data(), workIm.data(), false);
+
+        const uint64_t partition = pair * 2;
+        const size_t slot0 = (size_t) (partition % historySize) * numBins;
+        const size_t slot1 = (size_t) ((partition + 1) % historySize) * numBins;
+        for (int k = 0; k < numBins; k++) {
+            const int mirror = (convolutionSize - k) & (convolutionSize - 1);
+            const SampleType zRe = workRe[(size_t) k], zIm = workIm[(size_t) k];
+            const SampleType wRe = workRe[(size_t) mirror], wIm = workIm[(size_t) mirror];
+            historyRe[slot0 + (size_t) k] = (SampleType) 0.5 * (zRe + wRe);
+            historyIm[slot0 + (size_t) k] = (SampleType) 0.5 * (zIm - wIm);
+            historyRe[slot1 + (size_t) k] = (SampleType) 0.5 * (zIm + wIm);
+            historyIm[slot1 + (size_t) k] = (SampleType) 0.5 * (wRe - zRe);
+        }
+        if (out == nullptr)
+            return;
+
+        // each partition's output is the sum of every FIR partition times the input that far back
+        const Filter& filter = filters[front];
+        std::fill(sumRe.begin(), sumRe.end(), (SampleType) 0);
+        std::fill(sumIm.begin(), sumIm.end(), (SampleType) 0);
+        for (int half = 0; half < 2; half++) {
+            SampleType* NOISE_RESTRICT accRe = sumRe.data() + half * numBins;
+            SampleType* NOISE_RESTRICT accIm = sumIm.data() + half * numBins;
+            for (int p = 0; p < numPartitions; p++) {
+                const size_t slot = (size_t) ((partition + (uint64_t) (half + historySize - p)) % historySize) * numBins;
+                const SampleType* NOISE_RESTRICT xRe = historyRe + slot;
+                const SampleType* NOISE_RESTRICT xIm = historyIm + slot;
+                const SampleType* NOISE_RESTRICT hRe = filter.re.data() + p * numBins;
+                const SampleType* NOISE_RESTRICT hIm = filter.im.data() + p * numBins;
+                for (int k = 0; k < numBins; k++) {
+                    accRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+                    accIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+                }
+            }
+        }
+
+        // back through one transform too, the first output as the real part and the second as the
+        // imaginary part, each the full spectrum of a real signal
+        const SampleType* aRe = sumRe.data();
+        const SampleType* aIm = sumIm.data();
+        const SampleType* bRe = sumRe.data() + numBins;
+        const SampleType* bIm = sumIm.data() + numBins;
+        for (int k = 0; k < numBins; k++) {
+            workRe[(size_t) k] = aRe[k] - bIm[k];
+            workIm[(size_t) k] = aIm[k] + bRe[k];
+        }
+        for (int k = numBins; k < convolutionSize; k++) {
+            const int mirror = convolutionSize - k;
+            workRe[(size_t) k] = aRe[mirror] + bIm[mirror];
+            workIm[(size_t) k] = bRe[mirror] - aIm[mirror];
+        }
+        fft.perform(workRe.data(), workIm.data(), true);
+
+        // overlap-save, the second half of each window is the part that didn't wrap
+        std::copy(workRe.begin() + size, workRe.end(), out);
+        std::copy(workIm.begin() + size, workIm.end(), out + size);
+    }
+};
+
+template <typename SampleType = float>
+class ColouredNoise {
+public:
+    using Shape = ColouredNoiseShape<SampleType>;
+    static constexpr int pairSize = 2 * Shape::partitionSize;
+    // samples after jump() or restart() until the output is exactly what seek() would give
+    static constexpr int settleLength = Shape::firLength + pairSize;
+
+private:
+    Shape* shape = nullptr;
+    WhiteNoise white;
+    // spectra of the last historySize partitions, partition p in slot p % historySize
+    std::vector<SampleType> historyRe, historyIm;
+    // the current pair's output
+    std::vector<SampleType> out;
+    // where this stream's pairs start, see setPhase()
+    int phase = 0;
+    // the pair in out, and the next sample of it to hand out
+    uint64_t pair = 0;
+    int readPos = 0;
+    // index of the next sample generate() will produce
+    uint64_t position = 0;
+    // whether out holds anything yet
+    bool filled = false;
+
+    void fill(uint64_t newPair) {
+        pair = newPair;
+        shape->filterPair(white, pair, historyRe.data(), historyIm.data(), out.data());
+        readPos = 0;
+        filled = true;
+    }
+
+    // the pair a position falls in, and where in it
+    uint64_t getPair(uint64_t at) const { return (at + (uint64_t) phase) / pairSize; }
+    int getOffset(uint64_t at) const { return (int) ((at + (uint64_t) phase) % pairSize); }
+
+public:
+    ColouredNoise() { white.setMode(WhiteNoise::Mode::Counter); }
+
+    // sets the shape this stream uses, which has to outlive it, allocates its buffers and
+    // goes back to position 0
+    void prepare(Shape& shapeToUse) {
+        shape = &shapeToUse;
+        historyRe.assign((size_t) Shape::historySize * Shape::numBins, 0);
+        historyIm.assign((size_t) Shape::historySize * Shape::numBins, 0);
+        out.assign((size_t) pairSize, 0);
+        filled = false;
+        position = 0;
+    }
+
+    // restarts the stream from a new seed, at position 0
+    void setSeed(uint64_t seed) {
+        white.setSeed(seed);
+        restart(0);
+    }
+
+    // offsets where this stream's pairs start, from 0 to pairSize - 1, so streams with different
+    // phases filter their pairs in different blocks; a stream's output depends on its phase,
+    // so set it before generating and keep it
+    void setPhase(int newPhase) {
+        phase = std::max(0, std::min(pairSize - 1, newPhase));
+        restart(position);
+    }
+    int getPhase() const { return phase; }
+
+    // index of the next sample generate() will produce
+    uint64_t getPosition() const { return position; }
+
+    // the output at any position, exactly: the partitions the FIR reaches back over are
+    // transformed first, nothing to do if already there or in the same pair
+    void seek(uint64_t newPosition) {
+        if (newPosition == position)
+            return;
+
+        const uint64_t target = getPair(newPosition);
+        if (! filled || (target != pair && target != pair + 1)) {
+            // the pairs before the stream starts are silent
+            constexpr uint64_t reach = Shape::numPartitions / 2;
+            if (target < reach)
+                restart(newPosition);
+            for (uint64_t before = target < reach ? 0 : target - reach; before < target; before++)
+                shape->filterPair(white, before, historyRe.data(), historyIm.data(), nullptr);
+            fill(target);
+        }
+        else if (target != pair) {
+            // the next pair, the history already holds what it reaches back over
+            fill(target);
+        }
+        readPos = getOffset(newPosition);
+        position = newPosition;
+    }
+
+    // moves to any position for the cost of one pair: the spectra already in the history, from
+    // wherever the stream was, stand in for the partitions before it, so the output carries on as
+    // noise of the same colour and is exactly what seek() gives from settleLength samples on
+    void jump(uint64_t newPosition) {
+        if (filled && newPosition == position)
+            return;
+        const uint64_t target = getPair(newPosition);
+        if (! filled || target != pair)
+            fill(target);
+        readPos = getOffset(newPosition);
+        position = newPosition;
+    }
+
+    // forgets the partitions seen so far and moves to newPosition, as if the stream started
+    // there; costs nothing until generate(), and from settleLength samples on the output is
+    // exactly what seek() gives
+    void restart(uint64_t newPosition) {
+        std::fill(historyRe.begin(), historyRe.end(), (SampleType) 0);
+        std::fill(historyIm.begin(), historyIm.end(), (SampleType) 0);
+        filled = false;
+        position = newPosition;
+    }
+
+    // n samples of noise, filtering the next pair whenever the current one runs out
+    void generate(SampleType* dst, int n) {
+        if (shape == nullptr)
+            return;
+        if (! filled)
+            jump(position);
+
+        position += (uint64_t) n;
+        while (n > 0) {
+            if (readPos == pairSize)
+                fill(pair + 1);
+            const int count = std::min(n, pairSize - readPos);
+            std::copy(out.begin() + readPos, out.begin() + readPos + count, dst);
+            readPos += count;
+            dst += count;
+            n -= count;
+        }
+    }
+
+    // a single sample, for one sample at a time callers
+    SampleType generate() {
+        SampleType x = 0;
+        generate(&x, 1);
+        return x;
+    }
+};
@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    Dither.h
+    Created: 19 Oct 2026 9:12:18pm
+    Author:  John McRae
+
+    Dither and requantisation of the input, for reducing a mix or master
+    to 8, 16, 20 or 24 bits.
+
+    - Dither -
+
+    The dither is triangular (TPDF), 2 LSB peak to peak, which makes the
+    first two moments of the requantisation error independent of the
+    signal, so there is no distortion or noise modulation. It comes in
+    two kinds:
+
+        TPDF            the sum of two independent uniforms, white
+        High-pass TPDF  the difference of one uniform and the one before
+                        it, the same amplitude distribution but rising
+                        6 dB per octave, so there is less of it where the
+                        ear is most sensitive, for one uniform a sample
+
+    Like the generators' the dither only depends on the seed and the
+    sample position, taken from each channel's WhiteNoise in counter mode.
+
+    - Noise shaping -
+
+    The error of each sample is fed back through a short FIR and taken
+    off the next samples before they are quantised,
+
+        v[n] = x[n] - sum h[k] e[n - 1 - k],    e[n] = Q(v[n] + d[n]) - v[n]
+
+    so the error that reaches the output is e filtered by
+    1 - sum h[k] z^-(k + 1), moved away from where it would be heard:
+
+        Off             flat
+        First order     1 - z^-1, 6 dB per octave high-pass
+        Second order    (1 - z^-1)^2, 12 dB per octave
+        E-weighted      Lipshitz, Pocock and Vanderkooy's 5 tap filter,
+                        shaped to the threshold of hearing at 44.1 kHz
+        F-weighted      Wannamaker's 9 tap filter, the same at 44.1 kHz
+                        and deeper
+
+    The total noise power rises with the shaping. Once the output clips,
+    the error is held to a few LSB so the feedback can't run away.
+
+    - Lanes -
+
+    Without shaping each sample is independent, so each channel is
+    requantised straight from its buffer SimdVec::size samples at a time.
+    With shaping every sample depends on the errors before it, so the
+    channels are taken eight at a time and interleaved as in
+    NoiseFilterLanes, the filter running on every lane in the same
+    instruction; the tap count is fixed at compile time so the error
+    history stays in registers.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "NoiseSIMD.h"
+#include "WhiteNoise.h"
+
+enum class DitherType { TPDF, HighPassTPDF };
+enum class NoiseShaping { Off, FirstOrder, SecondOrder, EWeighted, FWeighted };
+
+template <typename SampleType = float>
+class DitherLanes {
+public:
+    // channels shaped together, a multiple of every SimdVec size
+    static constexpr int lanes = 8;
+    // longest noise shaping filter
+    static constexpr int maxTaps = 9;
+    // largest block process() works on in one go, longer blocks are split
+    static constexpr int chunkSize = 256;
+    // the bit depths that can be chosen
+    static constexpr int numDepths = 4;
+    static constexpr int depths[numDepths] = { 8, 16, 20, 24 };
+
+private:
+    using Vec = SimdVec<SampleType>;
+    static constexpr int vecsPerGroup = lanes / Vec::size;
+    // largest error fed back, in LSB, reached only while the output clips
+    static constexpr double errorLimit = 2.0;
+
+    // each channel's error history, e[n - 1 - k] at errors[k][lane]
+    struct alignas(64) Group {
+        SampleType errors[maxTaps][lanes] = {};
+    };
+    std::vector<Group> groups;
+    // white noise for each channel
+    std::vector<WhiteNoise> sources;
+    // a chunk of dither for each channel, in LSB
+    std::vector<SampleType> dither;
+
+    DitherType type = DitherType::TPDF;
+    NoiseShaping shaping = NoiseShaping::Off;
+    int bits = 16;
+    // full scale in LSB, 2^(bits - 1), and the largest and smallest output levels in LSB
+    SampleType scale = 32768, lowest = -32768, highest = 32767;
+    // seed the sources were last started from
+    uint64_t seed = WhiteNoise::makeRandomSeed();
+
+    // fills each channel's chunk of dither for the n samples from position
+    void generateDither(int numChannels, uint64_t position, int n) {
+        alignas(64) float uniforms[2 * chunkSize + 1];
+        for (int ch = 0; ch < numChannels; ch++) {
+            WhiteNoise& source = sources[(size_t) ch];
+            SampleType* NOISE_RESTRICT d = dither.data() + (size_t) ch * chunkSize;
+            if (type == DitherType::TPDF) {
+                // uniforms 2i and 2i + 1 for sample i, as WhiteDistribution's TPDF takes them
+                source.seek(2 * position);
+                source.generate(uniforms, 2 * n);
+                for (int s = 0; s < n; s++)
+                    d[s] = (SampleType) uniforms[2 * s] + (SampleType) uniforms[2 * s + 1] - 1;
+            }
+            else {
+                // uniform i less uniform i - 1, starting from the one before position
+                source.seek(position - 1);
+                source.generate(uniforms, n + 1);
+                for (int s = 0; s < n; s++)
+                    d[s] = (SampleType) uniforms[s + 1] - (SampleType) uniforms[s];
+            }
+        }
+    }
+
+    // requantises n samples of one channel in place, without shaping
+    void quantise(SampleType* NOISE_RESTRICT x, const SampleType* NOISE_RESTRICT d, int n) const {
+        const Vec toLsb = Vec::broadcast(scale), fromLsb = Vec::broadcast(1 / scale);
+        const Vec lo = Vec::broadcast(lowest), hi = Vec::broadcast(highest);
+        int s = 0;
+        for (; s + Vec::size <= n; s += Vec::size) {
+            const Vec v = Vec::load(x + s) * toLsb + Vec::load(d + s);
+            const Vec q = Vec::round(Vec::min(Vec::max(v, lo), hi));
+            (q * fromLsb).store(x + s);
+        }
+        for (; s < n; s++) {
+            const SampleType v = std::min(std::max(x[s] * scale + d[s], lowest), highest);
+            x[s] = std::nearbyint(v) / scale;
+        }
+    }
+
+    // requantises n interleaved samples of one group with a Taps tap error feedback filter
+    template <int Taps>
+    void shape(Group& group, SampleType* frame, const SampleType* ditherFrame, int n, const double* coefficients) const {
+        const Vec toLsb = Vec::broadcast(scale), fromLsb = Vec::broadcast(1 / scale);
+        const Vec lo = Vec::broadcast(lowest), hi = Vec::broadcast(highest);
+        const Vec eLo = Vec::broadcast((SampleType) -errorLimit), eHi = Vec::broadcast((SampleType) errorLimit);
+        Vec h[Taps], e[Taps][vecsPerGroup];
+        for (int k = 0; k < Taps; k++) {
+            h[k] = Vec::broadcast((SampleType) coefficients[k]);
+            for (int v = 0; v < vecsPerGroup; v++)
+                e[k][v] = Vec::load(group.errors[k] + v * Vec::size);
+        }
+        for (int s = 0; s < n; s++) {
+            SampleType* x = frame + s * lanes;
+            const SampleType* d = ditherFrame + s * lanes;
+            for (int v = 0; v < vecsPerGroup; v++) {
+                // the older errors first, so only the last one is on the chain from sample to sample
+                Vec older = Vec::load(x + v * Vec::size) * toLsb;
+                for (int k = Taps - 1; k > 0; k--)
+                    older -= h[k] * e[k][v];
+                const Vec dithered = older + Vec::load(d + v * Vec::size);
+                const Vec newest = h[0] * e[0][v];
+                const Vec target = older - newest;
+                const Vec q = Vec::round(Vec::min(Vec::max(dithered - newest, lo), hi));
+                for (int k = Taps - 1; k > 0; k--)
+                    e[k][v] = e[k - 1][v];
+                e[0][v] = Vec::min(Vec::max(q - target, eLo), eHi);
+                (q * fromLsb).store(x + v * Vec::size);
+            }
+        }
+        for (int k = 0; k < Taps; k++)
+            for (int v = 0; v < vecsPerGroup; v++)
+                e[k][v].store(group.errors[k] + v * Vec::size);
+    }
+
+    // the filter for shaping, and its length
+    static const double* getCoefficients(NoiseShaping shaping, int& taps) {
+        static const double firstOrder[] = { 1.0 };
+        static const double secondOrder[] = { 2.0, -1.0 };
+        // Lipshitz, Pocock and Vanderkooy, "Minimally Audible Noise Shaping", JAES 1991
+        static const double eWeighted[] = { 2.033, -2.165, 1.959, -1.590, 0.6149 };
+        // Wannamaker, "Psychoacoustically Optimal Noise Shaping", JAES 1992
+        static const double fWeighted[] = { 2.412, -3.370, 3.937, -4.174, 3.353, -2.205, 1.281, -0.569, 0.0847 };
+        switch (shaping) {
+            case NoiseShaping::FirstOrder:  taps = 1; return firstOrder;
+            case NoiseShaping::SecondOrder: taps = 2; return secondOrder;
+            case NoiseShaping::EWeighted:   taps = 5; return eWeighted;
+            case NoiseShaping::FWeighted:   taps = 9; return fWeighted;
+            case NoiseShaping::Off:         break;
+        }
+        taps = 0;
+        return nullptr;
+    }
+
+    // the shaped path for group g, whose first count channels are in channels
+    template <int Taps>
+    void processGroup(int g, SampleType* const* channels, int count, int n, const double* coefficients) {
+        alignas(64) SampleType frame[chunkSize * lanes];
+        alignas(64) SampleType ditherFrame[chunkSize * lanes];
+        const int first = g * lanes;
+        for (int lane = 0; lane < lanes; lane++) {
+            // lanes past the last channel shape silence, with any channel's dither
+            const SampleType* src = lane < count ? channels[lane] : nullptr;
+            const SampleType* d = dither.data() + (size_t) (first + std::min(lane, count - 1)) * chunkSize;
+            for (int s = 0; s < n; s++) {
+                frame[s * lanes + lane] = src != nullptr ? src[s] : 0;
+                ditherFrame[s * lanes + lane] = d[s];
+            }
+        }
+        shape<Taps>(groups[(size_t) g], frame, ditherFrame, n, coefficients);
+        for (int lane = 0; lane < count; lane++) {
+            SampleType* dst = channels[lane];
+            for (int s = 0; s < n; s++)
+                dst[s] = frame[s * lanes + lane];
+        }
+    }
+
+public:
+    DitherLanes(int numChannels = 0) { prepare(numChannels); }
+
+    // sizes the state for numChannels channels and restarts them from the current seed, allocates
+    void prepare(int numChannels) {
+        numChannels = std::max(0, numChannels);
+        groups.assign((size_t) ((numChannels + lanes - 1) / lanes), Group());
+        sources.resize((size_t) numChannels);
+        for (auto& source : sources)
+            source.setMode(WhiteNoise::Mode::Counter);
+        dither.assign((size_t) numChannels * chunkSize, 0);
+        setSeed(seed);
+    }
+    void release() {
+        groups = {};
+        sources = {};
+        dither = {};
+    }
+
+    int getNumChannels() const { return (int) sources.size(); }
+
+    // reseeds every channel's dither from one seed and clears the error histories
+    void setSeed(uint64_t newSeed) {
+        seed = newSeed;
+        uint64_t x = seed;
+        for (auto& source : sources)
+            source.setSeed(WhiteNoise::splitMix(x));
+        reset();
+    }
+    uint64_t getSeed() const { return seed; }
+
+    // clears the error histories
+    void reset() {
+        for (auto& group : groups)
+            group = Group();
+    }
+
+    void setType(DitherType newType) { type = newType; }
+    DitherType getType() const { return type; }
+
+    // the output word length, one of depths
+    void setBits(int newBits) {
+        if (newBits == bits)
+            return;
+        bits = std::max(2, std::min(newBits, 24));
+        scale = (SampleType) std::ldexp(1.0, bits - 1);
+        lowest = -scale;
+        highest = scale - 1;
+    }
+    int getBits() const { return bits; }
+
+    // a new filter starts from a clear history
+    void setShaping(NoiseShaping newShaping) {
+        if (newShaping == shaping)
+            return;
+        shaping = newShaping;
+        reset();
+    }
+    NoiseShaping getShaping() const { return shaping; }
+
+    // dithers and requantises n samples of the first numChannels channels in place, the block
+    // starting at sample position
+    void process(SampleType* const* buf, int numChannels, int n, uint64_t position) {
+        numChannels = std::min(numChannels, getNumChannels());
+        if (numChannels <= 0)
+            return;
+        int taps = 0;
+        const double* coefficients = getCoefficients(shaping, taps);
+        SampleType* chunk[lanes];
+
+        for (int start = 0; start < n; start += chunkSize) {
+            const int count = std::min(chunkSize, n - start);
+            generateDither(numChannels, position + (uint64_t) start, count);
+
+            if (taps == 0) {
+                for (int ch = 0; ch < numChannels; ch++)
+                    quantise(buf[ch] + start, dither.data() + (size_t) ch * chunkSize, count);
+                continue;
+            }
+            for (int g = 0; g * lanes < numChannels; g++) {
+                const int numLanes = std::min(lanes, numChannels - g * lanes);
+                for (int lane = 0; lane < numLanes; lane++)
+                    chunk[lane] = buf[g * lanes + lane] + start;
+                switch (taps) {
+                    case 1: processGroup<1>(g, chunk, numLanes, count, coefficients); break;
+                    case 2: processGroup<2>(g, chunk, numLanes, count, coefficients); break;
+                    case 5: processGroup<5>(g, chunk, numLanes, count, coefficients); break;
+                    default: processGroup<maxTaps>(g, chunk, numLanes, count, coefficients); break;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,872 @@
+/*
+  ==============================================================================
+
+    MultiChannelNoise.h
+    Created: 18 Oct 2026 2:17:48pm
+    Author:  John McRae
+
+    Independent noise for every channel of a bus, from mono up to 7.1.4,
+    arbitrary discrete layouts and speaker arrays of up to 128 channels.
+
+    Each channel has its own generator and filter state, so channel 1 is
+    no longer a continuation of channel 0. The state is kept as structures
+    of arrays and worked on in groups of eight channels: pink and brown
+    noise run each group through PinkNoiseLanes / BrownNoiseLanes, and
+    the smoothing and DC filters through NoiseFilterLanes, so every
+    channel of a group is generated and filtered in the same pass.
+
+    - Workers -
+
+    With a NoiseWorkers pool set (setWorkers()), render() hands the groups
+    of each chunk out to the pool's threads. The output is exactly the
+    same as rendering on one thread. The pool locks, so it is only for
+    offline rendering; the processor sets it while isNonRealtime().
+
+    - Width -
+
+    An extra common stream is generated alongside the channels. The width
+    control crossfades each channel between its own stream (width = 1,
+    fully decorrelated) and the common one (width = 0, every channel the
+    same) with equal power gains:
+
+        out = sqrt(width) * own + sqrt(1 - width) * common
+
+    Coloured noise has a stream per channel as well, ColouredNoise, which
+    all share one shaping filter. Each stream starts its pairs of
+    partitions at a different phase, so however many channels there are,
+    only a share of them run their FFTs in any one block.
+
+    - Distribution -
+
+    White noise can be uniform on [0, 1) as it always was, zero mean
+    uniform, TPDF or Gaussian, see WhiteDistribution.h. The distribution
+    is applied as the white noise is generated, so it costs no extra pass
+    and every channel and the common stream have the same one.
+
+    - Bands -
+
+    setBands() runs the noise through an octave or third octave band
+    filter after the smoothing and DC filters, see BandNoise.h. Every
+    channel can have the centre band, or each channel the next band up
+    from it, so a 32 channel bus carries all 31 third octave bands at
+    once. The bands are designed in setSampleRate() and each noise type
+    has its own filter state, like the other filters.
+
+    - Ramps -
+
+    render() can take the level as a ParameterRamp, which is written out
+    once a chunk and mixed in with one multiply per sample. The DC pole
+    and the smoothing length take a ramp length as well: the pole moves
+    every sample and the smoothing length a sample of length at a time,
+    keeping the running sums exact rather than restarting the smoothing.
+
+    - Position -
+
+    Every generator runs in WhiteNoise's counter mode, so the output only
+    depends on the seed and the sample position. Each noise type keeps
+    its own position, and seek() moves it anywhere, settling the filters
+    on the way, so a host's play head or a render thread can start at any
+    sample and get exactly what a run from the start would have produced.
+
+    Settling can take tens of thousands of samples per channel, too much
+    for one block while playing. So there are two sets of generators and
+    filters, seeded the same. With setRealtime() on, seek() leaves the
+    live set playing on from where it was and restarts the other set
+    before the new position; render() moves that set on resyncSpeed
+    samples for each one it renders, and once it has caught up crossfades
+    into it and makes it the live set.
+
+    - Precision -
+
+    MultiChannelNoise<double> runs the same lane kernels on double vectors
+    for hosts that process in double precision. The random values stay
+    single precision and are widened as they are read; the accumulators,
+    filters and mixing are double.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "NoiseSource.h"
+#include "ColouredNoise.h"
+#include "BandNoise.h"
+#include "NoiseWorkers.h"
+#include "WhiteDistribution.h"
+
+enum class NoiseType { White, Pink, Brown, Coloured };
+
+template <typename SampleType = float>
+class MultiChannelNoise {
+public:
+    using Type = NoiseType;
+    static constexpr int numTypes = 4;
+    static constexpr Type allTypes[numTypes] = { Type::White, Type::Pink, Type::Brown, Type::Coloured };
+
+    // most channels a bus can have
+    static constexpr int maxChannels = 128;
+    // channels generated together by each lane group
+    static constexpr int lanesPerGroup = 8;
+    // largest block generate() works on in one go, longer blocks are split
+    static constexpr int chunkSize = 256;
+    // while a seek settles in the background, samples settled for each sample rendered
+    static constexpr int resyncSpeed = 3;
+    // samples the live noise is crossfaded into the settled noise over
+    static constexpr int resyncFadeLength = chunkSize;
+
+private:
+    static_assert(NoiseFilterLanes<SampleType>::lanes == lanesPerGroup, "the filter groups line up with the generator groups");
+
+    // white noise for each channel, WhiteNoise keeps its state on cache lines of its own
+    // white noise is generated from its position every time, so both sets of streams share it
+    std::vector<WhiteNoise> channels;
+    // white noise source for the common stream
+    WhiteNoise commonWhite;
+    // amplitude distribution of the white noise
+    WhiteDistribution distribution = WhiteDistribution::Offset;
+    // the shaping filter every coloured stream shares
+    ColouredNoiseShape<SampleType> colouredShape;
+
+    // everything that moves on sample by sample, for every noise type
+    struct Streams {
+        // the smoothing and DC filters of every channel, one set for each noise source as before
+        NoiseFilterLanes<SampleType> filters[numTypes];
+        // lane groups, channel c is lane (c % lanesPerGroup) of group (c / lanesPerGroup)
+        // the lane after the last channel produces the common stream
+        std::vector<PinkNoiseLanes<lanesPerGroup, SampleType>> pinkGroups;
+        std::vector<BrownNoiseLanes<lanesPerGroup, SampleType>> brownGroups;
+        // a coloured stream for each channel plus the common one
+        std::vector<ColouredNoise<SampleType>> colouredStreams;
+        // the band filters for each noise type
+        BandFilterLanes<SampleType> bandFilters[numTypes];
+        // index of the next sample each noise type's streams will produce
+        uint64_t positions[numTypes] = {};
+    };
+    // two sets, seeded the same; for each noise type one is live and the other settles at a new
+    // position in the background after a seek() while rendering in real time
+    Streams sets[2];
+    int liveSet[numTypes] = {};
+
+    // a seek() settling in the background
+    struct Resync {
+        bool active = false;
+        // the filter stages it settles
+        bool smooth = false, dcBlock = false;
+        // where the filters start, the same sample an offline seek() starts them at; coloured
+        // streams start settleLength before it, so their output is exact by then
+        uint64_t filterStart = 0;
+        // samples of the crossfade from the live set done, -1 while it is still catching up
+        int faded = -1;
+    };
+    Resync resyncs[numTypes];
+    // whether seek() settles in the background rather than all at once, see setRealtime()
+    bool realtime = false;
+    // how far apart the streams' pairs start, close to pairSize / golden ratio so any number
+    // of streams spread their FFTs evenly over the blocks
+    static constexpr uint64_t colouredPhaseStep = 317;
+    // every band for the current rate
+    BandFilterDesign bandDesign;
+    BandMode bandMode = BandMode::Off;
+    float bandCentre = 1000.0f;
+    bool bandPerChannel = false;
+    // the longest any channel's band filter takes to settle
+    int bandSettleLength = 0;
+    // the common stream for the current chunk
+    alignas(64) SampleType common[chunkSize];
+    // the level at each sample of the current chunk while it ramps
+    alignas(64) SampleType levels[chunkSize];
+
+    // width and the gains derived from it
+    float width = 1.0f;
+    SampleType ownGain = 1, commonGain = 0;
+
+    // filter settings, applied to channels added by prepare()
+    float dcConst = 0.99f;
+    int smoothLength = 4, maxSmoothLength = SmoothingFilter<SampleType>::defaultMaxLength;
+
+    // seed the generators were last started from
+    uint64_t seed = WhiteNoise::makeRandomSeed();
+    // index of the next sample for each noise type, where the live set is unless it is resyncing
+    uint64_t positions[numTypes] = {};
+    // a chunk of scratch for each channel, used by render() and while seek() settles the filters,
+    // and another for the settling set while it resyncs
+    std::vector<SampleType> scratch, resyncScratch;
+    // pool render() splits the groups over, or nullptr to render on the calling thread
+    NoiseWorkers* workers = nullptr;
+
+    // points chunks[ch] at each channel's chunk of scratch
+    void getScratch(SampleType** chunks, int numChannels) {
+        for (int ch = 0; ch < numChannels; ch++)
+            chunks[ch] = scratch.data() + (size_t) ch * chunkSize;
+    }
+
+    static int getIndex(Type type) { return (int) type; }
+
+    Streams& getLive(Type type) { return sets[liveSet[getIndex(type)]]; }
+    Streams& getSettling(Type type) { return sets[1 - liveSet[getIndex(type)]]; }
+
+    // copies each channel's band into the band filters, allocates nothing
+    void updateBands() {
+        const int first = BandFilterDesign::getNearestBand(bandMode, bandCentre);
+        bandSettleLength = 0;
+        for (int ch = 0; ch < getNumChannels(); ch++) {
+            // channels past the last band are silent
+            const auto& band = bandDesign.getBand(bandMode, first + (bandPerChannel ? ch : 0));
+            for (auto& set : sets)
+                for (auto& filter : set.bandFilters)
+                    filter.setBand(ch, band);
+            bandSettleLength = std::max(bandSettleLength, BandFilterLanes<SampleType>::getSettleLength(band));
+        }
+    }
+
+    int getNumGroups() const { return (int) sets[0].pinkGroups.size(); }
+
+    // the common stream for the next n samples, when it is heard; pink and brown noise
+    // produce it in the last lane of their last group instead
+    template <Type type>
+    void generateCommon(Streams& set, int n) {
+        if (commonGain <= 0)
+            return;
+        if constexpr (type == Type::White) {
+            DistributedWhiteNoise::generate(distribution, commonWhite, set.positions[getIndex(Type::White)], common, n);
+        }
+        else if constexpr (type == Type::Coloured) {
+            set.colouredStreams.back().seek(set.positions[getIndex(Type::Coloured)]);
+            set.colouredStreams.back().generate(common, n);
+        }
+    }
+
+    // generates the next n samples of group g's channels, each channel pointer already offset
+    template <Type type>
+    void generateGroup(Streams& set, int g, SampleType* const* dst, int numChannels, int n) {
+        const int first = g * lanesPerGroup;
+
+        if constexpr (type == Type::White || type == Type::Coloured) {
+            // channels that weren't asked for, and the common stream while it isn't heard, are
+            // not generated, so every stream is put at the current position before it is used;
+            // that only costs anything for streams that have been left behind
+            const uint64_t position = set.positions[getIndex(type)];
+            const int last = std::min(first + lanesPerGroup, numChannels);
+            for (int ch = first; ch < last; ch++) {
+                if constexpr (type == Type::White) {
+                    DistributedWhiteNoise::generate(distribution, channels[(size_t) ch], position, dst[ch], n);
+                }
+                else {
+                    set.colouredStreams[(size_t) ch].seek(position);
+                    set.colouredStreams[(size_t) ch].generate(dst[ch], n);
+                }
+            }
+        }
+        else {
+            // pick out the buffers for the group's lanes, the common lane sits after the last channel;
+            // the lanes of channels we weren't given still have to be run to keep every stream
+            // aligned, they write into those channels' scratch
+            const int numLanes = getNumChannels() + 1;
+            const int count = std::min(lanesPerGroup, numLanes - first);
+            SampleType* lanes[lanesPerGroup];
+            for (int lane = 0; lane < count; lane++) {
+                const int ch = first + lane;
+                lanes[lane] = ch < numChannels ? dst[ch]
+                            : ch < getNumChannels() ? scratch.data() + (size_t) ch * chunkSize : common;
+            }
+            if constexpr (type == Type::Pink)
+                set.pinkGroups[(size_t) g].generate(lanes, count, n);
+            else
+                set.brownGroups[(size_t) g].generate(lanes, count, n);
+        }
+    }
+
+    // crossfades channels first to last - 1 towards the common stream, see setWidth()
+    void mixCommon(SampleType* const* dst, int first, int last, int n) const {
+        if (commonGain <= 0)
+            return;
+        for (int ch = first; ch < last; ch++) {
+            SampleType* d = dst[ch];
+            for (int s = 0; s < n; s++)
+                d[s] = ownGain * d[s] + commonGain * common[s];
+        }
+    }
+
+    // generates one chunk of up to chunkSize samples, each channel pointer already offset
+    template <Type type>
+    void generateChunk(Streams& set, SampleType* const* dst, int numChannels, int n) {
+        generateCommon<type>(set, n);
+        for (int g = 0; g < getNumGroups(); g++)
+            generateGroup<type>(set, g, dst, numChannels, n);
+        mixCommon(dst, 0, numChannels, n);
+    }
+
+    // the filters and the band filter of set for group g's channels of one chunk
+    template <Type type, bool Smooth, bool DC>
+    void filterGroup(Streams& set, int g, SampleType* const* wet, int numChannels, int n) {
+        const int first = g * lanesPerGroup;
+        const int count = std::min(lanesPerGroup, numChannels - first);
+        if (count <= 0)
+            return;
+
+        if constexpr (Smooth || DC) {
+            NOISE_TRACE_SCOPE("filters");
+            set.filters[getIndex(type)].processGroups(wet + first, first, count, n, Smooth, DC);
+        }
+
+        // the band filter is checked once a group rather than being another set of kernels
+        if (bandMode != BandMode::Off)
+            set.bandFilters[getIndex(type)].processGroups(wet + first, first, count, n);
+    }
+
+    // the dry/wet mix of group g's channels of one chunk into buf, which is offset to the
+    // chunk's start; uses the level at each sample from gains while the level ramps, otherwise level
+    void mixGroup(int g, SampleType* const* buf, SampleType* const* wet, int numChannels, int n, SampleType level, const SampleType* gains) const {
+        const int first = g * lanesPerGroup;
+        const int count = std::min(lanesPerGroup, numChannels - first);
+        if (count <= 0)
+            return;
+
+        NOISE_TRACE_SCOPE("mix");
+        if (gains != nullptr) {
+            // out * (1 - g) + w * g as one multiply
+            for (int ch = first; ch < first + count; ch++) {
+                const SampleType* NOISE_RESTRICT w = wet[ch];
+                SampleType* NOISE_RESTRICT out = buf[ch];
+                for (int s = 0; s < n; s++)
+                    out[s] += gains[s] * (w[s] - out[s]);
+            }
+            return;
+        }
+        const SampleType dryGain = 1 - level;
+        for (int ch = first; ch < first + count; ch++) {
+            const SampleType* NOISE_RESTRICT w = wet[ch];
+            SampleType* NOISE_RESTRICT out = buf[ch];
+            for (int s = 0; s < n; s++)
+                out[s] = out[s] * dryGain + w[s] * level;
+        }
+    }
+
+    // everything after generation for group g's channels of one chunk, see filterGroup and mixGroup
+    template <Type type, bool Smooth, bool DC>
+    void finishGroup(int g, SampleType* const* buf, SampleType* const* wet, int numChannels, int n, SampleType level, const SampleType* gains) {
+        filterGroup<type, Smooth, DC>(getLive(type), g, wet, numChannels, n);
+        mixGroup(g, buf, wet, numChannels, n, level, gains);
+    }
+
+    // puts set's streams for type at start with the filters cleared, ready to settle from there
+    void restart(Streams& set, Type type, uint64_t start, bool exact) {
+        set.filters[getIndex(type)].reset();
+        set.bandFilters[getIndex(type)].reset();
+        if (type == Type::Pink)
+            for (auto& group : set.pinkGroups)
+                group.seek(start);
+        if (type == Type::Brown)
+            for (auto& group : set.brownGroups)
+                group.seek(start);
+        // an exact seek of each coloured stream happens as it is next generated, otherwise
+        // they settle along with the filters
+        if (type == Type::Coloured && ! exact)
+            for (auto& stream : set.colouredStreams)
+                stream.restart(start);
+        set.positions[getIndex(type)] = start;
+    }
+
+    // generates and filters n samples of every channel of set into chunks, moving it on
+    template <Type type, bool Smooth, bool DC>
+    void settleChunk(Streams& set, SampleType* const* chunks, int n) {
+        const int numChannels = getNumChannels();
+        generateChunk<type>(set, chunks, numChannels, n);
+        for (int g = 0; g < getNumGroups(); g++)
+            filterGroup<type, Smooth, DC>(set, g, chunks, numChannels, n);
+        set.filters[getIndex(type)].advance(n, Smooth, DC);
+        set.positions[getIndex(type)] += (uint64_t) n;
+    }
+
+    // moves a resync of type on for a chunk of n samples whose live noise is in wet: the settling
+    // set catches up with the live position by up to resyncSpeed * n samples, and once it has,
+    // wet is crossfaded into its noise over resyncFadeLength samples and it becomes the live set
+    template <Type type, bool Smooth, bool DC>
+    void resyncChunk(SampleType* const* wet, int numChannels, int n) {
+        NOISE_TRACE_SCOPE("resync");
+        Resync& resync = resyncs[getIndex(type)];
+        Streams& settling = getSettling(type);
+        SampleType* chunks[maxChannels];
+        for (int ch = 0; ch < getNumChannels(); ch++)
+            chunks[ch] = resyncScratch.data() + (size_t) ch * chunkSize;
+
+        const uint64_t target = positions[getIndex(type)];
+        for (int budget = resyncSpeed * n; resync.faded < 0 && budget > 0; ) {
+            const uint64_t behind = target - settling.positions[getIndex(type)];
+            if (behind == 0) {
+                resync.faded = 0;
+                break;
+            }
+            const uint64_t at = settling.positions[getIndex(type)];
+            int count = (int) std::min<uint64_t>((uint64_t) std::min(chunkSize, budget), behind);
+            if (at < resync.filterStart) {
+                count = (int) std::min<uint64_t>((uint64_t) count, resync.filterStart - at);
+                generateChunk<type>(settling, chunks, getNumChannels(), count);
+                settling.positions[getIndex(type)] += (uint64_t) count;
+            }
+            else {
+                settleChunk<type, Smooth, DC>(settling, chunks, count);
+            }
+            budget -= count;
+        }
+        if (resync.faded < 0 && settling.positions[getIndex(type)] == target)
+            resync.faded = 0;
+        if (resync.faded < 0)
+            return;
+
+        // the settled noise for the same chunk, faded in linearly
+        generateChunk<type>(settling, chunks, numChannels, n);
+        for (int g = 0; g < getNumGroups(); g++)
+            filterGroup<type, Smooth, DC>(settling, g, chunks, numChannels, n);
+        settling.filters[getIndex(type)].advance(n, Smooth, DC);
+        settling.positions[getIndex(type)] += (uint64_t) n;
+
+        const SampleType step = (SampleType) 1 / resyncFadeLength;
+        for (int ch = 0; ch < numChannels; ch++) {
+            SampleType* NOISE_RESTRICT w = wet[ch];
+            const SampleType* NOISE_RESTRICT settled = chunks[ch];
+            for (int s = 0; s < n; s++) {
+                const SampleType fade = std::min((SampleType) 1, (SampleType) (resync.faded + s + 1) * step);
+                w[s] += fade * (settled[s] - w[s]);
+            }
+        }
+        resync.faded += n;
+        if (resync.faded >= resyncFadeLength) {
+            liveSet[getIndex(type)] ^= 1;
+            resync = Resync();
+        }
+    }
+
+    // render() for one configuration, the noise type and filter stages are fixed at compile time
+    // so the only branches left in the loops are the loops themselves; with a levelRamp the
+    // level comes from it instead of level
+    template <Type type, bool Smooth, bool DC>
+    void renderKernel(SampleType* const* buf, int numChannels, int n, SampleType level, ParameterRamp* levelRamp) {
+        SampleType* wet[maxChannels];
+        SampleType* out[maxChannels];
+        getScratch(wet, numChannels);
+        const int numGroups = getNumGroups();
+        // only worth waking the pool for more than one group of channels
+        NoiseWorkers* pool = numChannels > lanesPerGroup ? workers : nullptr;
+
+        // worked through in chunks, every channel at once
+        for (int start = 0; start < n; start += chunkSize) {
+            const int count = std::min(chunkSize, n - start);
+            for (int ch = 0; ch < numChannels; ch++)
+                out[ch] = buf[ch] + start;
+
+            // a ramping level is written out once for the chunk and read by every group
+            const SampleType* gains = nullptr;
+            if (levelRamp != nullptr) {
+                if (levelRamp->isRamping()) {
+                    levelRamp->fill(levels, count);
+                    gains = levels;
+                }
+                else {
+                    level = (SampleType) levelRamp->getValue();
+                }
+            }
+
+            // the set that is live for this chunk, a resync can swap them at its end
+            Streams& live = getLive(type);
+            if (pool == nullptr) {
+                {
+                    NOISE_TRACE_SCOPE("generate");
+                    generateChunk<type>(live, wet, numChannels, count);
+                }
+                for (int g = 0; g < numGroups; g++)
+                    filterGroup<type, Smooth, DC>(live, g, wet, numChannels, count);
+                if (resyncs[getIndex(type)].active)
+                    resyncChunk<type, Smooth, DC>(wet, numChannels, count);
+                for (int g = 0; g < numGroups; g++)
+                    mixGroup(g, out, wet, numChannels, count, level, gains);
+            }
+            else {
+                // the common stream comes first, every group mixes it in; the coloured streams
+                // share the shaping filter's FFT workspace, so they are all generated here too
+                const int commonGroup = getNumChannels() / lanesPerGroup;
+                constexpr bool lanesGenerator = type == Type::Pink || type == Type::Brown;
+                const bool commonFirst = lanesGenerator && commonGain > 0;
+                {
+                    NOISE_TRACE_SCOPE("generate");
+                    generateCommon<type>(live, count);
+                    if (commonFirst)
+                        generateGroup<type>(live, commonGroup, wet, numChannels, count);
+                    if constexpr (type == Type::Coloured)
+                        for (int g = 0; g < numGroups; g++)
+                            generateGroup<type>(live, g, wet, numChannels, count);
+                }
+
+                auto job = [&] (int g) {
+                    NOISE_TRACE_THREAD("noise worker");
+                    if (type != Type::Coloured && ! (commonFirst && g == commonGroup)) {
+                        NOISE_TRACE_SCOPE("generate");
+                        generateGroup<type>(live, g, wet, numChannels, count);
+                    }
+                    const int first = g * lanesPerGroup;
+                    mixCommon(wet, std::min(first, numChannels), std::min(first + lanesPerGroup, numChannels), count);
+                    finishGroup<type, Smooth, DC>(g, out, wet, numChannels, count, level, gains);
+                };
+                pool->run(numGroups, job);
+            }
+
+            live.filters[getIndex(type)].advance(count, Smooth, DC);
+            live.positions[getIndex(type)] += (uint64_t) count;
+            positions[getIndex(type)] += (uint64_t) count;
+        }
+    }
+
+    // settles the live set for type at its position all at once, running the filters over the
+    // samples just before it
+    void settle(Type type, bool smooth, bool dcBlock) {
+        const uint64_t position = positions[getIndex(type)];
+        const uint64_t settle = std::min(position, (uint64_t) getSettleLength(smooth, dcBlock));
+        Streams& live = getLive(type);
+        restart(live, type, position - settle, true);
+        positions[getIndex(type)] = position - settle;
+
+        NOISE_TRACE_SCOPE("seek settle");
+        const int numChannels = getNumChannels();
+        SampleType* chunks[maxChannels];
+        getScratch(chunks, numChannels);
+        for (uint64_t done = 0; done < settle; done += chunkSize) {
+            const int count = (int) std::min<uint64_t>(chunkSize, settle - done);
+            generate(type, chunks, numChannels, count);
+            process(type, chunks, numChannels, count, smooth, dcBlock);
+        }
+    }
+
+    // settles every seek still in progress at once
+    void finishResyncs() {
+        for (auto type : allTypes) {
+            Resync& resync = resyncs[getIndex(type)];
+            if (resync.active) {
+                settle(type, resync.smooth, resync.dcBlock);
+                resync = Resync();
+            }
+        }
+    }
+
+    using RenderKernel = void (MultiChannelNoise::*)(SampleType* const*, int, int, SampleType, ParameterRamp*);
+
+    // every instantiation of renderKernel, indexed by [type][smooth][dc]
+    static RenderKernel getRenderKernel(Type type, bool smooth, bool dcBlock) {
+        static const RenderKernel kernels[numTypes][2][2] = {
+            { { &MultiChannelNoise::renderKernel<Type::White, false, false>, &MultiChannelNoise::renderKernel<Type::White, false, true> },
+              { &MultiChannelNoise::renderKernel<Type::White, true,  false>, &MultiChannelNoise::renderKernel<Type::White, true,  true> } },
+            { { &MultiChannelNoise::renderKernel<Type::Pink,  false, false>, &MultiChannelNoise::renderKernel<Type::Pink,  false, true> },
+              { &MultiChannelNoise::renderKernel<Type::Pink,  true,  false>, &MultiChannelNoise::renderKernel<Type::Pink,  true,  true> } },
+            { { &MultiChannelNoise::renderKernel<Type::Brown, false, false>, &MultiChannelNoise::renderKernel<Type::Brown, false, true> },
+              { &MultiChannelNoise::renderKernel<Type::Brown, true,  false>, &MultiChannelNoise::renderKernel<Type::Brown, true,  true> } },
+            { { &MultiChannelNoise::renderKernel<Type::Coloured, false, false>, &MultiChannelNoise::renderKernel<Type::Coloured, false, true> },
+              { &MultiChannelNoise::renderKernel<Type::Coloured, true,  false>, &MultiChannelNoise::renderKernel<Type::Coloured, true,  true> } },
+        };
+        return kernels[getIndex(type)][smooth ? 1 : 0][dcBlock ? 1 : 0];
+    }
+
+public:
+    MultiChannelNoise(int numChannels = 2) { prepare(numChannels); }
+    // the coloured streams point at colouredShape, so an engine stays where it was made
+    MultiChannelNoise(const MultiChannelNoise&) = delete;
+    MultiChannelNoise& operator=(const MultiChannelNoise&) = delete;
+
+    // sets up state for numChannels channels and restarts every stream from the current seed
+    // allocates so call it from prepareToPlay
+    void prepare(int numChannels) {
+        numChannels = std::max(1, std::min(numChannels, maxChannels));
+        const int numGroups = (numChannels + 1 + lanesPerGroup - 1) / lanesPerGroup;
+
+        channels.resize((size_t) numChannels);
+        scratch.resize((size_t) numChannels * chunkSize);
+        resyncScratch.resize((size_t) numChannels * chunkSize);
+        for (auto& set : sets) {
+            for (auto& filter : set.filters)
+                filter.prepare(numChannels);
+            set.pinkGroups.resize((size_t) numGroups);
+            set.brownGroups.resize((size_t) numGroups);
+            set.colouredStreams.resize((size_t) numChannels + 1);
+            for (size_t s = 0; s < set.colouredStreams.size(); s++) {
+                set.colouredStreams[s].prepare(colouredShape);
+                set.colouredStreams[s].setPhase((int) ((s * colouredPhaseStep) % ColouredNoise<SampleType>::pairSize));
+            }
+            for (auto& filter : set.bandFilters)
+                filter.prepare(numChannels);
+            for (auto& group : set.pinkGroups)
+                group.setMode(WhiteNoise::Mode::Counter);
+            for (auto& group : set.brownGroups)
+                group.setMode(WhiteNoise::Mode::Counter);
+        }
+
+        for (auto& white : channels)
+            white.setMode(WhiteNoise::Mode::Counter);
+        DistributedWhiteNoise::prepare();
+        commonWhite.setMode(WhiteNoise::Mode::Counter);
+        setSeed(seed);
+
+        for (auto& set : sets) {
+            for (auto& filter : set.filters) {
+                filter.setMaxSmoothLength(maxSmoothLength);
+                filter.setSmoothLength(smoothLength);
+                filter.setDCfiltConst(dcConst);
+            }
+        }
+        updateBands();
+    }
+
+    // frees the per channel state and scratch, render() does nothing until prepare() is called again
+    void release() {
+        channels = {};
+        scratch = {};
+        resyncScratch = {};
+        for (auto& set : sets) {
+            for (auto& filter : set.filters)
+                filter.release();
+            set.pinkGroups = {};
+            set.brownGroups = {};
+            set.colouredStreams = {};
+            for (auto& filter : set.bandFilters)
+                filter.release();
+            for (auto& position : set.positions)
+                position = 0;
+        }
+        for (auto& position : positions)
+            position = 0;
+        for (auto& resync : resyncs)
+            resync = Resync();
+    }
+
+    // reseeds every generator from one seed and goes back to position 0, so the whole bus can be reproduced
+    void setSeed(uint64_t newSeed) {
+        seed = newSeed;
+        // both sets get the same seeds, so either can take over from the other
+        for (auto& set : sets) {
+            uint64_t x = seed;
+            auto next = [&x]() { return WhiteNoise::splitMix(x); };
+            for (auto& white : channels)
+                white.setSeed(next());
+            commonWhite.setSeed(next());
+            for (auto& group : set.pinkGroups)
+                group.setSeed(next());
+            for (auto& group : set.brownGroups)
+                group.setSeed(next());
+            for (auto& stream : set.colouredStreams)
+                stream.setSeed(next());
+            for (auto& filter : set.filters)
+                filter.reset();
+            for (auto& filter : set.bandFilters)
+                filter.reset();
+            for (auto& position : set.positions)
+                position = 0;
+        }
+        for (auto& position : positions)
+            position = 0;
+        for (auto& resync : resyncs)
+            resync = Resync();
+    }
+    uint64_t getSeed() const { return seed; }
+
+    // index of the next sample generate() will produce for type
+    uint64_t getPosition(Type type) const { return positions[getIndex(type)]; }
+
+    // moves the stream for type to sample position, and settles that type's filters
+    // with the given stages enabled by running them over the samples just before it
+    // costs at most getSettleLength() samples per channel, nothing if already there;
+    // with setRealtime() on it costs nothing here and the settling is spread over the
+    // following render() calls instead, see setRealtime()
+    void seek(Type type, uint64_t position, bool smooth, bool dcBlock) {
+        uint64_t& current = positions[getIndex(type)];
+        if (position == current || channels.empty())
+            return;
+
+        Resync& resync = resyncs[getIndex(type)];
+        current = position;
+        resync = Resync();
+        // the live set is exact wherever it is, a jump back there needs no settling
+        if (position == getLive(type).positions[getIndex(type)])
+            return;
+
+        if (realtime && workers == nullptr) {
+            const uint64_t filterStart = position - std::min(position, (uint64_t) getSettleLength(smooth, dcBlock));
+            const uint64_t streamSettle = type == Type::Coloured ? (uint64_t) ColouredNoise<SampleType>::settleLength : 0;
+            restart(getSettling(type), type, filterStart - std::min(filterStart, streamSettle), false);
+            resync.active = true;
+            resync.smooth = smooth;
+            resync.dcBlock = dcBlock;
+            resync.filterStart = filterStart;
+            return;
+        }
+        settle(type, smooth, dcBlock);
+    }
+
+    // settles type's filters again where its stream is, all at once, as a seek() there from
+    // anywhere else would; carrying on from the samples before isn't bit-exact with that once
+    // a band is on (see BandNoise.h), so this keeps output that may come either way the same
+    void resettle(Type type, bool smooth, bool dcBlock) {
+        if (channels.empty())
+            return;
+        resyncs[getIndex(type)] = Resync();
+        settle(type, smooth, dcBlock);
+    }
+
+    // the longest run seek() makes the filters settle over
+    int getSettleLength(bool smooth, bool dcBlock) const {
+        if (channels.empty())
+            return 0;
+        return sets[0].filters[0].getSettleLength(smooth, dcBlock) + (bandMode != BandMode::Off ? bandSettleLength : 0);
+    }
+
+    // with realtime on, seek() only starts the settling and render() carries on with the noise
+    // it was playing; the other set of streams settles at the new position a chunk at a time,
+    // resyncSpeed samples for every sample rendered, then is crossfaded in over resyncFadeLength
+    // samples, from when on the output is exactly what an offline seek() would give. So a jump
+    // never costs more than a few blocks' worth of work in any one block
+    // turning it off, or setting a pool of workers, settles any seek still in progress at once
+    void setRealtime(bool shouldBeRealtime) {
+        realtime = shouldBeRealtime;
+        if (! realtime)
+            finishResyncs();
+    }
+    bool isRealtime() const { return realtime; }
+    // whether a seek() of type is still settling in the background
+    bool isResyncing(Type type) const { return resyncs[getIndex(type)].active; }
+
+    int getNumChannels() const { return (int) channels.size(); }
+
+    // splits render() between the pool's threads, nullptr to render on the calling thread
+    // the pool locks and wakes threads, so only set it while rendering offline
+    void setWorkers(NoiseWorkers* pool) {
+        workers = pool;
+        if (workers != nullptr)
+            finishResyncs();
+    }
+    NoiseWorkers* getWorkers() const { return workers; }
+
+    // 1 gives every channel its own noise, 0 gives every channel the same noise
+    void setWidth(float newWidth) {
+        width = std::max(0.0f, std::min(1.0f, newWidth));
+        ownGain = std::sqrt((SampleType) width);
+        commonGain = std::sqrt((SampleType) (1.0f - width));
+    }
+    float getWidth() const { return width; }
+
+    // the white noise's amplitude distribution, see WhiteDistribution.h
+    // takes effect from the next sample, the stream's position is kept
+    void setDistribution(WhiteDistribution newDistribution) { distribution = newDistribution; }
+    WhiteDistribution getDistribution() const { return distribution; }
+
+    // the coloured noise's 1/f^a exponent, or grey noise, see ColouredNoise.h
+    // works the shaping filter out again on the calling thread when either changes, which does
+    // not allocate but takes a design FFT and a few thousand pow() calls
+    void setColour(float exponent, bool grey) { colouredShape.setColour(exponent, grey); }
+    // setColour() for another thread, e.g. the message thread while the audio thread plays:
+    // render() takes the new filter up at its next call, false if it has to be tried again
+    bool designColour(float exponent, bool grey) { return colouredShape.design(exponent, grey); }
+    float getColourExponent() const { return colouredShape.getExponent(); }
+    bool isColourGrey() const { return colouredShape.isGrey(); }
+    // the coloured noise's shaping filter and the band filters depend on the sample rate
+    void setSampleRate(double sampleRate) {
+        colouredShape.setSampleRate(sampleRate);
+        bandDesign.setSampleRate(sampleRate);
+        updateBands();
+    }
+
+    // band limits the noise to the octave or third octave band nearest centre (Hz), or with
+    // perChannel gives channel c the band c bands above it, BandMode::Off for the full band
+    // only copies coefficients, the bands are designed by setSampleRate()
+    void setBands(BandMode mode, float centre, bool perChannel) {
+        if (mode == bandMode && centre == bandCentre && perChannel == bandPerChannel)
+            return;
+        bandMode = mode;
+        bandCentre = centre;
+        bandPerChannel = perChannel;
+        updateBands();
+    }
+    BandMode getBandMode() const { return bandMode; }
+    float getBandCentre() const { return bandCentre; }
+    bool isBandPerChannel() const { return bandPerChannel; }
+
+    // generates n samples of noise into numChannels buffers, numChannels must not exceed getNumChannels()
+    void generate(Type type, SampleType* const* dst, int numChannels, int n) {
+        if (channels.empty())
+            return;
+        NOISE_TRACE_SCOPE("generate");
+        colouredShape.acquire();
+        Streams& live = getLive(type);
+        numChannels = std::min(numChannels, getNumChannels());
+        SampleType* offset[maxChannels];
+        for (int start = 0; start < n; start += chunkSize) {
+            const int count = std::min(chunkSize, n - start);
+            SampleType* const* chunk = dst;
+            if (start > 0) {
+                for (int ch = 0; ch < numChannels; ch++)
+                    offset[ch] = dst[ch] + start;
+                chunk = offset;
+            }
+            switch (type) {
+                case Type::White: generateChunk<Type::White>(live, chunk, numChannels, count); break;
+                case Type::Pink:  generateChunk<Type::Pink>(live, chunk, numChannels, count);  break;
+                case Type::Brown: generateChunk<Type::Brown>(live, chunk, numChannels, count); break;
+                case Type::Coloured: generateChunk<Type::Coloured>(live, chunk, numChannels, count); break;
+            }
+            live.positions[getIndex(type)] += (uint64_t) count;
+            positions[getIndex(type)] += (uint64_t) count;
+        }
+    }
+
+    // runs each channel's filters for the given noise type over its buffer, then the band filter if on
+    void process(Type type, SampleType* const* buf, int numChannels, int n, bool smooth, bool dcBlock) {
+        NOISE_TRACE_SCOPE("filters");
+        numChannels = std::min(numChannels, getNumChannels());
+        Streams& live = getLive(type);
+        live.filters[getIndex(type)].process(buf, numChannels, n, smooth, dcBlock);
+        if (bandMode != BandMode::Off)
+            live.bandFilters[getIndex(type)].process(buf, numChannels, n);
+    }
+
+    // the processor's whole noise path: generates and filters noise, then mixes it into buf
+    // in place, buf = buf * (1 - level) + noise * level
+    // the configuration is looked up once per call, see renderKernel
+    void render(Type type, SampleType* const* buf, int numChannels, int n, bool smooth, bool dcBlock, SampleType level) {
+        if (channels.empty())
+            return;
+        numChannels = std::min(numChannels, getNumChannels());
+        colouredShape.acquire();
+        (this->*getRenderKernel(type, smooth, dcBlock))(buf, numChannels, n, level, nullptr);
+    }
+    // render() with the level following a ramp, which is moved on n samples
+    void render(Type type, SampleType* const* buf, int numChannels, int n, bool smooth, bool dcBlock, ParameterRamp& level) {
+        if (channels.empty()) {
+            level.skip(n);
+            return;
+        }
+        numChannels = std::min(numChannels, getNumChannels());
+        colouredShape.acquire();
+        (this->*getRenderKernel(type, smooth, dcBlock))(buf, numChannels, n, (SampleType) level.getValue(), &level);
+    }
+
+    // filter settings, applied to every channel; with a rampLength the DC pole ramps and the
+    // smoothing length glides to the new value over that many samples, see NoiseFilterLanes
+    void setDCfiltConst(float sliderVal, int rampLength = 0) {
+        dcConst = sliderVal;
+        for (auto& set : sets)
+            for (auto& filter : set.filters)
+                filter.setDCfiltConst(sliderVal, rampLength);
+    }
+    void setSmoothLength(int sliderVal, int rampLength = 0) {
+        smoothLength = sliderVal;
+        for (auto& set : sets) {
+            for (auto& filter : set.filters) {
+                if (rampLength > 0)
+                    filter.glideSmoothLength(sliderVal, rampLength);
+                else
+                    filter.setSmoothLength(sliderVal);
+            }
+        }
+    }
+    // longest smoothing length, allocates so call it from prepareToPlay
+    void setMaxSmoothLength(int maxLength) {
+        maxSmoothLength = maxLength;
+        for (auto& set : sets)
+            for (auto& filter : set.filters)
+                filter.setMaxSmoothLength(maxLength);
+    }
+};
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    NoiseFFT.h
+    Created: 19 Oct 2026 10:31:52am
+    Author:  John McRae
+
+    Small in place radix-2 complex FFT, shared by the spectrum analyser
+    and the FFT shaped coloured noise. Standard library only, like the
+    rest of the DSP headers.
+
+    The real and imaginary parts are kept in separate arrays, and the
+    twiddle factors for every stage are stored one after the other, so
+    the butterfly loops read everything contiguously and the compiler can
+    vectorise them. prepare() allocates the tables; perform() allocates
+    nothing and can run on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "NoiseSIMD.h"
+
+template <typename T = float>
+class NoiseFFT {
+private:
+    int order = 0, size = 0;
+    // twiddles for the stage of length 2h start at index h - 1
+    std::vector<T> cosTable, sinTable;
+    std::vector<int> bitReversed;
+
+public:
+    NoiseFFT(int fftOrder = 0) { prepare(fftOrder); }
+
+    // sets the size to 2^fftOrder, allocates
+    void prepare(int fftOrder) {
+        order = fftOrder;
+        size = 1 << fftOrder;
+        cosTable.assign((size_t) std::max(1, size - 1), 0);
+        sinTable.assign((size_t) std::max(1, size - 1), 0);
+        bitReversed.assign((size_t) size, 0);
+
+        const double twoPi = 6.283185307179586;
+        for (int half = 1; half < size; half <<= 1) {
+            for (int k = 0; k < half; k++) {
+                const double angle = -twoPi * k / (2 * half);
+                cosTable[(size_t) (half - 1 + k)] = (T) std::cos(angle);
+                sinTable[(size_t) (half - 1 + k)] = (T) std::sin(angle);
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            int reversed = 0;
+            for (int bit = 0; bit < order; bit++)
+                reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+            bitReversed[(size_t) i] = reversed;
+        }
+    }
+
+    int getSize() const { return size; }
+
+    // transforms re + i im in place, forward with e^-i, inverse with e^+i and unscaled
+    void perform(T* re, T* im, bool inverse) const {
+        for (int i = 0; i < size; i++) {
+            const int j = bitReversed[(size_t) i];
+            if (i < j) {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+
+        // the tables hold e^-i, the inverse flips the sine
+        const T flip = inverse ? (T) -1 : (T) 1;
+
+        // the first two stages together, their twiddles are 1 and -i (+i inverse), so no multiplies
+        if (size >= 4) {
+            for (int start = 0; start < size; start += 4) {
+                T* NOISE_RESTRICT r = re + start;
+                T* NOISE_RESTRICT m = im + start;
+                const T aRe = r[0] + r[1], aIm = m[0] + m[1];
+                const T bRe = r[0] - r[1], bIm = m[0] - m[1];
+                const T cRe = r[2] + r[3], cIm = m[2] + m[3];
+                // (r[2] - r[3]) times the twiddle
+                const T dRe = flip * (m[2] - m[3]), dIm = -flip * (r[2] - r[3]);
+                r[0] = aRe + cRe;  m[0] = aIm + cIm;
+                r[2] = aRe - cRe;  m[2] = aIm - cIm;
+                r[1] = bRe + dRe;  m[1] = bIm + dIm;
+                r[3] = bRe - dRe;  m[3] = bIm - dIm;
+            }
+        }
+
+        for (int half = size >= 4 ? 4 : 1; half < size; half <<= 1) {
+            const T* c = cosTable.data() + half - 1;
+            const T* s = sinTable.data() + half - 1;
+            for (int start = 0; start < size; start += 2 * half) {
+                T* NOISE_RESTRICT aRe = re + start;
+                T* NOISE_RESTRICT aIm = im + start;
+                T* NOISE_RESTRICT bRe = aRe + half;
+                T* NOISE_RESTRICT bIm = aIm + half;
+                for (int k = 0; k < half; k++) {
+                    const T wIm = flip * s[k];
+                    const T oRe = bRe[k] * c[k] - bIm[k] * wIm;
+                    const T oIm = bRe[k] * wIm + bIm[k] * c[k];
+                    bRe[k] = aRe[k] - oRe;
+                    bIm[k] = aIm[k] - oIm;
+                    aRe[k] += oRe;
+                    aIm[k] += oIm;
+                }
+            }
+        }
+    }
+};
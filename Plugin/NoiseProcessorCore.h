@@ -0,0 +1,460 @@
+/*
+  ==============================================================================
+
+    NoiseProcessorCore.h
+    Created: 20 Oct 2026 10:41:12am
+    Author:  John McRae
+
+    Everything processBlock does with a block of audio, built without JUCE
+    so the plugin and NoiseBench --check-realtime run the same code: the
+    parameters' values pushed through to the engines, then the dither, the
+    MIDI synth, the noise or the level adjust, whichever the block calls for.
+
+    The processor reads its parameters into a NoiseParameters (or takes a
+    factory program's whole), works out the block's position on the timeline
+    and hands both over with the audio and the MIDI. Everything the block
+    touches is held here in both precisions, and prepare() sizes the one the
+    host is going to use, so process() never allocates.
+
+    MIDI arrives as any range of events with data, numBytes and
+    samplePosition members, which is what iterating a juce::MidiBuffer
+    gives; the three byte channel messages the synth plays are read
+    straight from the bytes.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "Dither.h"
+#include "MultiChannelNoise.h"
+#include "NoiseSynth.h"
+#include "NoiseTelemetry.h"
+#include "NoiseTrace.h"
+#include "NoiseWorkers.h"
+#include "ParameterRamp.h"
+
+// every parameter value a block needs, in the parameters' own values (not 0 to 1)
+struct NoiseParameters {
+    bool  white, pink, brown, on, dc, avg;
+    float level, dcConst, width;
+    int   smoothLength;
+    bool  colour, grey;
+    float exponent;
+    int   band;
+    float bandCentre;
+    bool  bandSpread;
+    int   distribution;
+    bool  synth;
+    float attack, decay, sustain, release;
+    bool  dither;
+    int   ditherType, ditherBits, shaping;
+};
+
+// a factory program
+struct NoiseProgram {
+    const char* name;
+    NoiseParameters params;
+};
+
+// the factory programs: white, pink, brown, on, dc, avg, level, dc constant, width, smooth length,
+// coloured, grey, exponent, band (0 off, 1 octave, 2 third octave), band centre, band per channel,
+// white distribution (0 uniform 0 to 1, 1 uniform, 2 TPDF, 3 Gaussian), MIDI synth, attack, decay (ms),
+// sustain, release (ms), dither, dither type (0 TPDF, 1 high-pass TPDF), bit depth (0 8, 1 16, 2 20, 3 24),
+// noise shaping (0 off, 1 first order, 2 second order, 3 E-weighted, 4 F-weighted)
+inline constexpr int numFactoryPrograms = 15;
+inline const NoiseProgram factoryPrograms[numFactoryPrograms] =
+{
+    { "Init",         { false, false, false, true, true,  true,  0.0f, 0.99f,  1.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "White",        { true,  false, false, true, true,  false, 0.5f, 0.99f,  1.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Pink",         { false, true,  false, true, true,  false, 0.5f, 0.99f,  1.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Brown",        { false, false, true,  true, true,  false, 0.5f, 0.99f,  1.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Soft White",   { true,  false, false, true, true,  true,  0.5f, 0.99f,  1.0f, 8, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Mono Pink",    { false, true,  false, true, true,  false, 0.5f, 0.99f,  0.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Deep Brown",   { false, false, true,  true, true,  false, 0.5f, 0.999f, 1.0f, 4, false, false,  1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Blue",         { false, false, false, true, true,  false, 0.5f, 0.99f,  1.0f, 4, true,  false, -1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Violet",       { false, false, false, true, true,  false, 0.5f, 0.99f,  1.0f, 4, true,  false, -2.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Grey",         { false, false, false, true, true,  false, 0.5f, 0.99f,  1.0f, 4, true,  true,   1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Pink 1k Third Octave", { false, true, false, true, true, false, 0.5f, 0.99f, 1.0f, 4, false, false, 1.0f, 2, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Third Octave Bands",   { false, true, false, true, true, false, 0.5f, 0.99f, 1.0f, 4, false, false, 1.0f, 2, 20.0f,   true, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Gaussian White",       { true, false, false, true, true, false, 0.5f, 0.99f, 1.0f, 4, false, false, 1.0f, 0, 1000.0f, false, 3, false, 5.0f, 100.0f, 0.7f, 200.0f, false, 0, 1, 0 } },
+    { "Noise Snare",          { true, false, false, true, true, false, 0.5f, 0.99f, 1.0f, 4, false, false, 1.0f, 0, 1000.0f, false, 1, true, 1.0f, 150.0f, 0.0f, 80.0f, false, 0, 1, 0 } },
+    { "Dither to 16 Bit",     { false, false, false, true, false, false, 0.0f, 0.99f, 1.0f, 4, false, false, 1.0f, 0, 1000.0f, false, 1, false, 5.0f, 100.0f, 0.7f, 200.0f, true, 0, 1, 3 } },
+};
+
+class NoiseProcessorCore {
+    // generator and filter state for every channel, see MultiChannelNoise.h
+    // only the one matching the host's processing precision is prepared
+    MultiChannelNoise<float> noise;
+    MultiChannelNoise<double> noiseDouble;
+    // threads an offline render of a wide bus is split between, started in prepare()
+    NoiseWorkers workers;
+    // the MIDI played noise voices, see NoiseSynth.h, prepared in the host's precision like the engines
+    NoiseSynth<float> synth;
+    NoiseSynth<double> synthDouble;
+    // sample position the synth's next block is expected at, it starts over when the play head jumps
+    int64_t synthPosition = 0;
+    // dither and requantisation of the input, see Dither.h, prepared in the host's precision like the engines
+    DitherLanes<float> dither;
+    DitherLanes<double> ditherDouble;
+    // the level as the engines and the level adjust play it, ramped to each block's value, see ParameterRamp.h
+    ParameterRamp levelRamp { ParameterRamp::Shape::Exponential };
+    // the shortest ramp, in samples, set for the sample rate in prepare()
+    int minRampLength = 0;
+    // the values the filters are currently set to
+    float dcFilterRatio = 0.99f;
+    int smoothLength = 4;
+    // which precision prepare() last sized
+    bool doublePrecision = false;
+    // where a jump's settle is counted, if anywhere
+    NoiseTelemetry* telemetry = nullptr;
+
+    template <typename SampleType>
+    MultiChannelNoise<SampleType>& getNoise() {
+        if constexpr (std::is_same<SampleType, double>::value)
+            return noiseDouble;
+        else
+            return noise;
+    }
+    template <typename SampleType>
+    NoiseSynth<SampleType>& getSynth() {
+        if constexpr (std::is_same<SampleType, double>::value)
+            return synthDouble;
+        else
+            return synth;
+    }
+    template <typename SampleType>
+    DitherLanes<SampleType>& getDither() {
+        if constexpr (std::is_same<SampleType, double>::value)
+            return ditherDouble;
+        else
+            return dither;
+    }
+
+public:
+    // sizes everything a block touches for numChannels channels in one precision and releases
+    // the other, so process() never allocates; nothing depends on the block size, the noise is
+    // rendered in fixed size chunks. The filters start from the values they were last set to
+    // and process() ramps them to the parameters, the level and colour start at params'.
+    // An offline render of a wide bus is split between one thread per core; the pool locks, so
+    // it is only started while the host isn't playing live
+    void prepare(double sampleRate, int numChannels, bool useDouble, bool nonRealtime, int maxSmoothLength,
+                 uint64_t seed, const NoiseParameters& params) {
+        doublePrecision = useDouble;
+        auto prepareEngine = [&](auto& engine, auto& voices, auto& requantiser) {
+            engine.prepare(numChannels);
+            engine.setMaxSmoothLength(maxSmoothLength);
+            engine.setSeed(seed);
+            engine.setDCfiltConst(dcFilterRatio);
+            engine.setSmoothLength(smoothLength);
+            engine.setColour(params.exponent, params.grey);
+
+            // the synth's whole voice pool, whether or not it is going to be played
+            voices.setMaxSmoothLength(maxSmoothLength);
+            voices.setDCfiltConst(dcFilterRatio);
+            voices.setSmoothLength(smoothLength);
+            voices.prepare();
+            voices.setSeed(seed);
+
+            requantiser.prepare(numChannels);
+            requantiser.setSeed(seed);
+        };
+        // the coloured noise's shaping filter and every band filter are worked out for the rate,
+        // in both engines like the filters
+        noise.setSampleRate(sampleRate);
+        noiseDouble.setSampleRate(sampleRate);
+        synth.setSampleRate(sampleRate);
+        synthDouble.setSampleRate(sampleRate);
+        // the shortest a parameter change is ramped over, 5 ms
+        minRampLength = (int) std::lround(sampleRate * 0.005);
+        levelRamp.setValue(params.level);
+
+        if (useDouble) {
+            prepareEngine(noiseDouble, synthDouble, ditherDouble);
+            noise.release();
+            synth.release();
+            dither.release();
+        }
+        else {
+            prepareEngine(noise, synth, dither);
+            noiseDouble.release();
+            synthDouble.release();
+            ditherDouble.release();
+        }
+
+        if (nonRealtime && numChannels > MultiChannelNoise<>::lanesPerGroup)
+            workers.start();
+        else
+            workers.stop();
+    }
+
+    void release() {
+        noise.release();
+        noiseDouble.release();
+        synth.release();
+        synthDouble.release();
+        dither.release();
+        ditherDouble.release();
+        workers.stop();
+    }
+
+    // counts each jump's settle in telemetry's statistics, or nowhere with nullptr
+    void setTelemetry(NoiseTelemetry* newTelemetry) { telemetry = newTelemetry; }
+
+    // works the coloured noise's shaping filter out for the prepared engine off the audio thread,
+    // which takes it up at its next block; false if a design was already under way
+    bool designColour(float exponent, bool grey) {
+        return doublePrecision ? noiseDouble.designColour(exponent, grey) : noise.designColour(exponent, grey);
+    }
+
+    // whether a jump of type's noise is still being settled in the background
+    bool isResyncing(NoiseType type) const {
+        return doublePrecision ? noiseDouble.isResyncing(type) : noise.isResyncing(type);
+    }
+
+    // a block that isn't processed, e.g. bypassed; the level still moves on
+    void skip(int numSamples) { levelRamp.skip(numSamples); }
+
+    // processes numSamples samples of the first numChannels channels in place, the input on the
+    // way in and the output on the way out, in the prepared precision. position is where the
+    // block starts on the timeline, the noise being a function of it, and nonRealtime is whether
+    // the host is rendering offline rather than playing. Returns true, having left the audio
+    // alone, when the whole block is to be silence, so the caller can clear it the way its
+    // buffer marks itself cleared for anything downstream that checks
+    template <typename SampleType, typename MidiEvents>
+    bool process(SampleType* const* channels, int numChannels, int numSamples, const MidiEvents& midi,
+                 const NoiseParameters& params, int64_t position, uint64_t seed, bool nonRealtime) {
+        MultiChannelNoise<SampleType>& engine = getNoise<SampleType>();
+        NoiseSynth<SampleType>& voices = getSynth<SampleType>();
+        DitherLanes<SampleType>& requantiser = getDither<SampleType>();
+
+        // every change ramps over the block, or a few milliseconds if the block is shorter, so the
+        // output follows automation from block to block and still never jumps
+        const int rampLength = std::max(numSamples, minRampLength);
+        levelRamp.setTarget(params.level, rampLength);
+
+        // check slider values and update filters if changed
+        updateFilters(params, rampLength, nonRealtime);
+
+        // a new seed arrives with a restored state
+        if (seed != engine.getSeed())
+            engine.setSeed(seed);
+        if (seed != voices.getSeed())
+            voices.setSeed(seed);
+        if (seed != requantiser.getSeed())
+            requantiser.setSeed(seed);
+
+        // the worker pool is only used while rendering offline, a pool that was never started
+        // runs everything on this thread without locking
+        engine.setWorkers(nonRealtime ? &workers : nullptr);
+        // while playing, a jump is settled in the background over the next blocks rather than in this one
+        engine.setRealtime(! nonRealtime);
+
+        // check if noise is on, with nothing selected or the level at zero the input passes through untouched
+        // and nothing is generated; when the noise is next heard it is seeked back into place, which while
+        // playing is settled over the next blocks and crossfaded in, so coming back costs no more than a
+        // jump of the play head, and the level fades it in from silence
+        const bool noiseIsSelected = params.white || params.pink || params.brown || params.colour;
+        // pick the noise source once for the whole block
+        const auto type = params.white ? NoiseType::White
+                        : params.pink  ? NoiseType::Pink
+                        : params.brown ? NoiseType::Brown : NoiseType::Coloured;
+
+        // dither replaces the noise: the input is dithered and requantised, the level isn't used;
+        // the dither follows the timeline like the noise, so a bounce is the same every time
+        if (params.on && params.dither) {
+            NOISE_TRACE_SCOPE("dither");
+            requantiser.process(channels, std::min(numChannels, requantiser.getNumChannels()), numSamples, (uint64_t) position);
+            levelRamp.skip(numSamples);
+        }
+        // the synth plays the noise from MIDI instead, even with the level at zero so the notes keep time
+        else if (params.on && noiseIsSelected && params.synth) {
+            // its voices only move on while they sound, so it starts over whenever the play head jumps
+            // (or it was last heard at some other position), which keeps bounces from one point identical
+            if (position != synthPosition)
+                voices.reset();
+            synthPosition = position + numSamples;
+            playSynth(channels, numChannels, numSamples, midi, voices, type, params);
+        }
+        else if (params.on && noiseIsSelected && (levelRamp.getValue() > 0 || levelRamp.isRamping())) {
+            numChannels = std::min(numChannels, engine.getNumChannels());
+
+            // only costs anything after a jump, when the filters are settled at the new position, all
+            // at once offline and spread over the next blocks while playing
+            // negative positions (pre-roll) wrap round to the end of the stream, which is just as good
+            if (telemetry != nullptr && (uint64_t) position != engine.getPosition(type))
+                telemetry->addResync(std::min((uint64_t) position, (uint64_t) engine.getSettleLength(params.avg, params.dc)));
+            {
+                NOISE_TRACE_SCOPE("seek");
+                engine.seek(type, (uint64_t) position, params.avg, params.dc);
+            }
+
+            // noise source, then smoothing and dc block, level adjust and mix the dry and the wet
+            NOISE_TRACE_SCOPE("render");
+            engine.render(type, channels, numChannels, numSamples, params.avg, params.dc, levelRamp);
+        }
+        // if noise is off, use the slider as a level adjust
+        else if (! params.on) {
+            const SampleType gain = (SampleType) levelRamp.getValue();
+            if (levelRamp.isRamping()) {
+                // the ramp is written out a chunk at a time and every channel multiplied by it
+                static constexpr int chunkSize = MultiChannelNoise<SampleType>::chunkSize;
+                alignas(64) SampleType gains[chunkSize];
+                for (int start = 0; start < numSamples; start += chunkSize) {
+                    const int count = std::min(chunkSize, numSamples - start);
+                    levelRamp.fill(gains, count);
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        multiply(channels[channel] + start, gains, count);
+                }
+            }
+            // silence is left to the caller; unity gain leaves the input alone
+            else if (gain == 0) {
+                return true;
+            }
+            else if (gain != 1) {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    multiply(channels[channel], gain, numSamples);
+            }
+        }
+        // nothing to hear, the level still moves on
+        else {
+            levelRamp.skip(numSamples);
+        }
+        return false;
+    }
+
+private:
+    // the level adjust's gain, a vector at a time with NoiseSIMD.h's wrappers rather than left to
+    // the compiler, as FloatVectorOperations::multiply did before the block moved out of JUCE
+    template <typename SampleType>
+    static void multiply(SampleType* x, const SampleType* gains, int n) {
+        using Vec = SimdVec<SampleType>;
+        int s = 0;
+        for (; s + Vec::size <= n; s += Vec::size)
+            (Vec::load(x + s) * Vec::load(gains + s)).store(x + s);
+        for (; s < n; s++)
+            x[s] *= gains[s];
+    }
+    template <typename SampleType>
+    static void multiply(SampleType* x, SampleType gain, int n) {
+        using Vec = SimdVec<SampleType>;
+        const Vec g = Vec::broadcast(gain);
+        int s = 0;
+        for (; s + Vec::size <= n; s += Vec::size)
+            (Vec::load(x + s) * g).store(x + s);
+        for (; s < n; s++)
+            x[s] *= gain;
+    }
+
+    // pushes slider changes through to the filters, only touches them when a value has changed,
+    // and ramps the DC pole and smoothing length over rampLength samples
+    void updateFilters(const NoiseParameters& params, int rampLength, bool nonRealtime) {
+        // both engines are kept in step, so either is ready if the host changes precision
+        // the DC pole ramps to its new value over rampLength samples
+        if (params.dcConst != dcFilterRatio) {
+            noise.setDCfiltConst(params.dcConst, rampLength);
+            noiseDouble.setDCfiltConst(params.dcConst, rampLength);
+            synth.setDCfiltConst(params.dcConst, rampLength);
+            synthDouble.setDCfiltConst(params.dcConst, rampLength);
+            dcFilterRatio = params.dcConst;
+        }
+        // the smoothing length glides through the lengths in between, adjusting the running
+        // sums from the history rather than restarting it, and allocates nothing
+        if (params.smoothLength != smoothLength) {
+            noise.setSmoothLength(params.smoothLength, rampLength);
+            noiseDouble.setSmoothLength(params.smoothLength, rampLength);
+            synth.setSmoothLength(params.smoothLength, rampLength);
+            synthDouble.setSmoothLength(params.smoothLength, rampLength);
+            smoothLength = params.smoothLength;
+        }
+        if (params.width != noise.getWidth()) {
+            noise.setWidth(params.width);
+            noiseDouble.setWidth(params.width);
+        }
+        // the coloured noise's shaping filter is worked out off the audio thread while playing,
+        // see designColour(); offline it is worked out here as the slider moves, only in the
+        // engine that is prepared, which prepare() brings up to date when the precision changes
+        if (nonRealtime) {
+            if (doublePrecision) {
+                if (params.exponent != noiseDouble.getColourExponent() || params.grey != noiseDouble.isColourGrey())
+                    noiseDouble.setColour(params.exponent, params.grey);
+            }
+            else if (params.exponent != noise.getColourExponent() || params.grey != noise.isColourGrey()) {
+                noise.setColour(params.exponent, params.grey);
+            }
+        }
+        // picking a band only copies coefficients designed in prepare()
+        const auto bandMode = (BandMode) std::max(0, std::min(2, params.band));
+        if (bandMode != noise.getBandMode() || params.bandCentre != noise.getBandCentre() || params.bandSpread != noise.isBandPerChannel()) {
+            noise.setBands(bandMode, params.bandCentre, params.bandSpread);
+            noiseDouble.setBands(bandMode, params.bandCentre, params.bandSpread);
+        }
+        // the distribution is applied as the white noise is generated, nothing to work out
+        const auto distribution = (WhiteDistribution) std::max(0, std::min(3, params.distribution));
+        if (distribution != noise.getDistribution()) {
+            noise.setDistribution(distribution);
+            noiseDouble.setDistribution(distribution);
+            synth.setDistribution(distribution);
+            synthDouble.setDistribution(distribution);
+        }
+        // the synth's envelope works out a step per sample for each stage, nothing else
+        const float attack = params.attack * 0.001f, decay = params.decay * 0.001f, release = params.release * 0.001f;
+        if (attack != synth.getAttack() || decay != synth.getDecay() || params.sustain != synth.getSustain() || release != synth.getRelease()) {
+            synth.setEnvelope(attack, decay, params.sustain, release);
+            synthDouble.setEnvelope(attack, decay, params.sustain, release);
+        }
+        // the dither settings are a few assignments, a new shaping filter clears the error history
+        const auto ditherType = (DitherType) std::max(0, std::min(1, params.ditherType));
+        const int ditherBits = DitherLanes<>::depths[std::max(0, std::min(DitherLanes<>::numDepths - 1, params.ditherBits))];
+        const auto shaping = (NoiseShaping) std::max(0, std::min(4, params.shaping));
+        dither.setType(ditherType);
+        dither.setBits(ditherBits);
+        dither.setShaping(shaping);
+        ditherDouble.setType(ditherType);
+        ditherDouble.setBits(ditherBits);
+        ditherDouble.setShaping(shaping);
+    }
+
+    // plays the synth's voices over the block, stopping at each MIDI event to start or stop notes
+    template <typename SampleType, typename MidiEvents>
+    void playSynth(SampleType* const* channels, int numChannels, int numSamples, const MidiEvents& midi,
+                   NoiseSynth<SampleType>& voices, NoiseType type, const NoiseParameters& params) {
+        NOISE_TRACE_SCOPE("synth");
+        numChannels = std::min(numChannels, MultiChannelNoise<>::maxChannels);
+        SampleType* from[MultiChannelNoise<>::maxChannels];
+        int start = 0;
+
+        // plays the voices from start up to sample end
+        auto playTo = [&](int end) {
+            if (end <= start)
+                return;
+            for (int channel = 0; channel < numChannels; ++channel)
+                from[channel] = channels[channel] + start;
+            voices.render(type, from, numChannels, end - start, params.avg, params.dc, levelRamp);
+            start = end;
+        };
+
+        // every event lands on its own sample; sysex and the like are skipped
+        for (const auto& event : midi) {
+            if (event.numBytes > 3)
+                continue;
+            playTo(std::max(0, std::min(numSamples, event.samplePosition)));
+
+            const int status = event.data[0] & 0xf0, channel = (event.data[0] & 0x0f) + 1;
+            const int data1 = event.numBytes > 1 ? event.data[1] : 0, data2 = event.numBytes > 2 ? event.data[2] : 0;
+            if (status == 0x90 && data2 > 0)
+                voices.noteOn(channel, data1, (float) data2 / 127.0f);
+            else if (status == 0x80 || status == 0x90)
+                voices.noteOff(channel, data1);
+            // all notes off, and all sound off
+            else if (status == 0xb0 && data1 == 123)
+                voices.allNotesOff();
+            else if (status == 0xb0 && data1 == 120)
+                voices.reset();
+        }
+        playTo(numSamples);
+    }
+};
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    NoiseSIMD.h
+    Created: 18 Oct 2026 11:05:37am
+    Author:  John McRae
+
+    Platform detection and the small vectors used by the lane based
+    generators and filters: SimdVec<float> holds 4 floats and
+    SimdVec<double> holds 2 doubles, so the same kernel code serves both
+    processing precisions.
+
+    They map onto SSE2 on x86 and NEON on ARM, both of which are always
+    available on the 64 bit targets we build for, and fall back to plain
+    arrays elsewhere (double NEON needs AArch64). Kernels that are worth
+    building for wider instruction sets (see WhiteNoise.h) pick them at
+    runtime instead.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #define NOISE_SIMD_X86 1
+ #include <immintrin.h>
+ #if defined(_MSC_VER) && ! defined(__clang__)
+  #include <intrin.h>
+  // MSVC lets intrinsics for any instruction set be used without a target attribute
+  #define NOISE_TARGET_AVX2
+  #define NOISE_TARGET_AVX512
+ #else
+  #define NOISE_TARGET_AVX2   __attribute__((target("avx2")))
+  #define NOISE_TARGET_AVX512 __attribute__((target("avx512f")))
+ #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #define NOISE_SIMD_NEON 1
+ #include <arm_neon.h>
+ #if defined(__aarch64__) || defined(_M_ARM64)
+  #define NOISE_SIMD_NEON64 1
+ #endif
+#endif
+
+#if defined(_MSC_VER)
+ #define NOISE_RESTRICT __restrict
+#else
+ #define NOISE_RESTRICT __restrict__
+#endif
+
+template <typename T> struct SimdVec;
+using FloatVec = SimdVec<float>;
+using DoubleVec = SimdVec<double>;
+
+// four floats processed together
+template <>
+struct SimdVec<float> {
+    static constexpr int size = 4;
+
+#if NOISE_SIMD_X86
+    __m128 v;
+
+    static FloatVec load (const float* p)          { return { _mm_loadu_ps(p) }; }
+    static FloatVec loadFloat (const float* p)     { return load(p); }
+    static FloatVec broadcast (float x)            { return { _mm_set1_ps(x) }; }
+    void store (float* p) const                    { _mm_storeu_ps(p, v); }
+
+    friend FloatVec operator+ (FloatVec a, FloatVec b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend FloatVec operator- (FloatVec a, FloatVec b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend FloatVec operator* (FloatVec a, FloatVec b) { return { _mm_mul_ps(a.v, b.v) }; }
+    static FloatVec min (FloatVec a, FloatVec b)       { return { _mm_min_ps(a.v, b.v) }; }
+    static FloatVec max (FloatVec a, FloatVec b)       { return { _mm_max_ps(a.v, b.v) }; }
+    // nearest integer, ties to even, for |a| < 2^31
+    static FloatVec round (FloatVec a)                 { return { _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)) }; }
+#elif NOISE_SIMD_NEON
+    float32x4_t v;
+
+    static FloatVec load (const float* p)          { return { vld1q_f32(p) }; }
+    static FloatVec loadFloat (const float* p)     { return load(p); }
+    static FloatVec broadcast (float x)            { return { vdupq_n_f32(x) }; }
+    void store (float* p) const                    { vst1q_f32(p, v); }
+
+    friend FloatVec operator+ (FloatVec a, FloatVec b) { return { vaddq_f32(a.v, b.v) }; }
+    friend FloatVec operator- (FloatVec a, FloatVec b) { return { vsubq_f32(a.v, b.v) }; }
+    friend FloatVec operator* (FloatVec a, FloatVec b) { return { vmulq_f32(a.v, b.v) }; }
+    static FloatVec min (FloatVec a, FloatVec b)       { return { vminq_f32(a.v, b.v) }; }
+    static FloatVec max (FloatVec a, FloatVec b)       { return { vmaxq_f32(a.v, b.v) }; }
+  #if NOISE_SIMD_NEON64
+    static FloatVec round (FloatVec a)                 { return { vrndnq_f32(a.v) }; }
+  #else
+    // 32 bit ARM has no round to nearest, so halves go away from zero here
+    static FloatVec round (FloatVec a)                 { return { vcvtq_f32_s32(vcvtq_s32_f32(vaddq_f32(a.v, vbslq_f32(vcltq_f32(a.v, vdupq_n_f32(0)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f))))) }; }
+  #endif
+#else
+    float v[4];
+
+    static FloatVec load (const float* p)          { return { { p[0], p[1], p[2], p[3] } }; }
+    static FloatVec loadFloat (const float* p)     { return load(p); }
+    static FloatVec broadcast (float x)            { return { { x, x, x, x } }; }
+    void store (float* p) const                    { for (int i = 0; i < 4; i++) p[i] = v[i]; }
+
+    friend FloatVec operator+ (FloatVec a, FloatVec b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+    friend FloatVec operator- (FloatVec a, FloatVec b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; }
+    friend FloatVec operator* (FloatVec a, FloatVec b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+    static FloatVec min (FloatVec a, FloatVec b)       { for (int i = 0; i < 4; i++) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+    static FloatVec max (FloatVec a, FloatVec b)       { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+    static FloatVec round (FloatVec a)                 { for (int i = 0; i < 4; i++) a.v[i] = std::nearbyint(a.v[i]); return a; }
+#endif
+
+    FloatVec& operator+= (FloatVec b) { return *this = *this + b; }
+    FloatVec& operator-= (FloatVec b) { return *this = *this - b; }
+    FloatVec& operator*= (FloatVec b) { return *this = *this * b; }
+};
+
+// two doubles processed together
+template <>
+struct SimdVec<double> {
+    static constexpr int size = 2;
+
+#if NOISE_SIMD_X86
+    __m128d v;
+
+    static DoubleVec load (const double* p)         { return { _mm_loadu_pd(p) }; }
+    // widens two floats, used where the random values stay in single precision
+    static DoubleVec loadFloat (const float* p)     { return { _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*) p))) }; }
+    static DoubleVec broadcast (double x)           { return { _mm_set1_pd(x) }; }
+    void store (double* p) const                    { _mm_storeu_pd(p, v); }
+
+    friend DoubleVec operator+ (DoubleVec a, DoubleVec b) { return { _mm_add_pd(a.v, b.v) }; }
+    friend DoubleVec operator- (DoubleVec a, DoubleVec b) { return { _mm_sub_pd(a.v, b.v) }; }
+    friend DoubleVec operator* (DoubleVec a, DoubleVec b) { return { _mm_mul_pd(a.v, b.v) }; }
+    static DoubleVec min (DoubleVec a, DoubleVec b)       { return { _mm_min_pd(a.v, b.v) }; }
+    static DoubleVec max (DoubleVec a, DoubleVec b)       { return { _mm_max_pd(a.v, b.v) }; }
+    // nearest integer, ties to even, for |a| < 2^31
+    static DoubleVec round (DoubleVec a)                  { return { _mm_cvtepi32_pd(_mm_cvtpd_epi32(a.v)) }; }
+#elif NOISE_SIMD_NEON64
+    float64x2_t v;
+
+    static DoubleVec load (const double* p)         { return { vld1q_f64(p) }; }
+    static DoubleVec loadFloat (const float* p)     { return { vcvt_f64_f32(vld1_f32(p)) }; }
+    static DoubleVec broadcast (double x)           { return { vdupq_n_f64(x) }; }
+    void store (double* p) const                    { vst1q_f64(p, v); }
+
+    friend DoubleVec operator+ (DoubleVec a, DoubleVec b) { return { vaddq_f64(a.v, b.v) }; }
+    friend DoubleVec operator- (DoubleVec a, DoubleVec b) { return { vsubq_f64(a.v, b.v) }; }
+    friend DoubleVec operator* (DoubleVec a, DoubleVec b) { return { vmulq_f64(a.v, b.v) }; }
+    static DoubleVec min (DoubleVec a, DoubleVec b)       { return { vminq_f64(a.v, b.v) }; }
+    static DoubleVec max (DoubleVec a, DoubleVec b)       { return { vmaxq_f64(a.v, b.v) }; }
+    static DoubleVec round (DoubleVec a)                  { return { vrndnq_f64(a.v) }; }
+#else
+    double v[2];
+
+    static DoubleVec load (const double* p)         { return { { p[0], p[1] } }; }
+    static DoubleVec loadFloat (const float* p)     { return { { p[0], p[1] } }; }
+    static DoubleVec broadcast (double x)           { return { { x, x } }; }
+    void store (double* p) const                    { p[0] = v[0]; p[1] = v[1]; }
+
+    friend DoubleVec operator+ (DoubleVec a, DoubleVec b) { for (int i = 0; i < 2; i++) a.v[i] += b.v[i]; return a; }
+    friend DoubleVec operator- (DoubleVec a, DoubleVec b) { for (int i = 0; i < 2; i++) a.v[i] -= b.v[i]; return a; }
+    friend DoubleVec operator* (DoubleVec a, DoubleVec b) { for (int i = 0; i < 2; i++) a.v[i] *= b.v[i]; return a; }
+    static DoubleVec min (DoubleVec a, DoubleVec b)       { for (int i = 0; i < 2; i++) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+    static DoubleVec max (DoubleVec a, DoubleVec b)       { for (int i = 0; i < 2; i++) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+    static DoubleVec round (DoubleVec a)                  { for (int i = 0; i < 2; i++) a.v[i] = std::nearbyint(a.v[i]); return a; }
+#endif
+
+    DoubleVec& operator+= (DoubleVec b) { return *this = *this + b; }
+    DoubleVec& operator-= (DoubleVec b) { return *this = *this - b; }
+    DoubleVec& operator*= (DoubleVec b) { return *this = *this * b; }
+};
@@ -22,6 +22,12 @@
        x       x       x       x
            x               x
                    x
+
+    PinkNoiseLanes runs 4, 8 or 16 of these generators side by side, one
+    per channel or voice, with the row updates done as vector operations.
+    Its rows are rounded to a multiple of 2^-19 so that the running sum is
+    always exact, which lets seek() rebuild it from scratch and land on
+    exactly the value the running sum would have reached.
     
     - Brown Noise -
     
@@ -29,31 +35,84 @@
     is implented using a right Riemann sum and propagates over a buffer
     to produce new samples.
 
+    The default streaming mode runs the same leaky integrator sample by
+    sample and normalizes by its known variance instead of by the buffer
+    min/max, so it has a constant cost per sample and no buffer at all.
+
+    All of the generators draw their random numbers from WhiteNoise.h.
+
+    - Seeking -
+
+    With their WhiteNoise in counter mode the lane generators can seek()
+    straight to any sample. Pink noise rebuilds each row from the random
+    value it last took. The brown integrator, and the filters (see
+    NoiseFilter::getSettleLength), forget their past geometrically, so
+    they are restarted a little before the target and run up to it.
+
+    - Precision -
+
+    Every generator and filter takes a SampleType, float by default or
+    double. The double versions use the same lane kernels on double
+    vectors (see NoiseSIMD.h); the random values are still drawn as
+    floats and widened as they are read.
+
   ==============================================================================
 */
 
 #pragma once
-#include <JuceHeader.h>
+// the generators and filters only need the standard library, so they can be
+// built without JUCE, e.g. for the command line tools
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+#include "NoiseSIMD.h"
+#include "NoiseTrace.h"
+#include "ParameterRamp.h"
+#include "WhiteNoise.h"
+#if defined(_MSC_VER)
+ #include <intrin.h>
+#endif
+
+// number of trailing zero bits in x, x must not be zero
+// used by the McCartney-Voss generators to pick the row to update
+inline int countTrailingZeros (uint32_t x) {
+#if defined(_MSC_VER) && ! defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (int) index;
+#else
+    return __builtin_ctz(x);
+#endif
+}
 
+template <typename SampleType = float>
 class PinkNoise {
 private:
-    // random noise generator from the JUCE library
-    juce::Random noiseSrc;
+    // vectorized random noise generator, see WhiteNoise.h
+    WhiteNoise noiseSrc;
     // each row effectively holds an independent random number generator
-    std::vector<float> pinkRows;
+    std::vector<SampleType> pinkRows;
     // running sum for noise output
-    float pinkRunSum;
+    SampleType pinkRunSum;
     // the column index, incremented each sample
     int pinkIndex;
     // the row mask, which ensures that the index of the pinkRows vector is never exceeded
     int pinkIndexMask;
     // used to normalize the noise at the output
-    float pinkNorm;
+    SampleType pinkNorm;
 
 public:
+    // rows reserved by the constructor, setRows() up to this many never allocates
+    static constexpr int reservedRows = 16;
+
     // constructor, overload to initialize with 12 rows, which worked out to be a
     // good number when testing in Octave
     PinkNoise(int numRows = 12) {
+        pinkRows.reserve((size_t) std::max(numRows, reservedRows));
         pinkIndex = 0;
         // mask the index so it does not spill outside of the pinkRows vector range
         pinkIndexMask = (1 << numRows) - 1;
@@ -67,8 +126,8 @@ public:
     }
     
     // generates pink noise one sample at a time
-    float generate() {
-        float newRandom, sum;
+    SampleType generate() {
+        SampleType newRandom, sum;
 
         // increment and mask index
         pinkIndex = (pinkIndex + 1) & pinkIndexMask;
@@ -76,13 +135,7 @@ public:
         // ensure pink index is not zero, if it is, do not update any of the random vals
         if (pinkIndex != 0) {
             // determine the number of trailing zeros in pinkIndex
-            int numZeros = 0;
-            int n = pinkIndex;
-            while ((n & 1) == 0) {
-                // bit shift until you run out of trailing zeros
-                n = n >> 1;
-                numZeros++;
-            }
+            int numZeros = countTrailingZeros((uint32_t) pinkIndex);
             // McCARTNEY-VOSS ALGORITHM
             // subtract previous value from running sum
             pinkRunSum -= pinkRows[numZeros];
@@ -101,10 +154,39 @@ public:
         return (sum * pinkNorm);
     }
 
+    // generates a block of n pink noise samples into dst
+    // the running sum, index and mask are held in locals for the whole block
+    // so that the member state is only loaded and stored once per call
+    void generate(SampleType* dst, int n) {
+        NOISE_TRACE_SCOPE("pink");
+        SampleType runSum = pinkRunSum;
+        int index = pinkIndex;
+        const int mask = pinkIndexMask;
+        const SampleType norm = pinkNorm;
+        SampleType* rows = pinkRows.data();
+
+        for (int s = 0; s < n; s++) {
+            index = (index + 1) & mask;
+
+            if (index != 0) {
+                int numZeros = countTrailingZeros((uint32_t) index);
+                SampleType newRandom = noiseSrc.nextFloat();
+                runSum += newRandom - rows[numZeros];
+                rows[numZeros] = newRandom;
+            }
+
+            dst[s] = (runSum + noiseSrc.nextFloat()) * norm;
+        }
+
+        pinkRunSum = runSum;
+        pinkIndex = index;
+    }
+
     // Changes the number of noise generating rows
     // Note that this overrides the initialization found in the constructor
     // AS WELL AS the pinkRows vector. Therefore, it is advised that this
     // function only be called on initialization
+    // allocates only when newRows is more than the rows reserved so far
     void setRows(int newRows) {
         // reset pinkIndex
         pinkIndex = 0;
@@ -119,34 +201,269 @@ public:
     }
 };
 
+// Runs Lanes independent McCartney-Voss pink noise generators side by side,
+// one per channel or voice. All lanes share the column index, so every step
+// updates the same row in each lane and the update is a plain vector operation.
+// Rows live in a fixed size aligned array, so changing the row count never allocates.
+template <int Lanes, typename SampleType = float>
+class PinkNoiseLanes {
+    static_assert(Lanes == 4 || Lanes == 8 || Lanes == 16, "PinkNoiseLanes supports 4, 8 or 16 lanes");
+
+public:
+    // largest number of rows setRows() accepts
+    static constexpr int maxRows = 16;
+
+private:
+    using Vec = SimdVec<SampleType>;
+
+    // number of steps generated per pass through the random scratch buffer
+    static constexpr int chunkSteps = 32;
+
+    // random noise generator shared by all lanes, each lane draws its own values
+    WhiteNoise noiseSrc;
+    // the rows for each lane, stored as pinkRows[row][lane]
+    alignas(64) SampleType pinkRows[maxRows][Lanes];
+    // running sum for each lane
+    alignas(64) SampleType pinkRunSum[Lanes];
+    // random values for a chunk, two per lane per step: one for the row update and one extra white value
+    alignas(64) float rnd[chunkSteps * 2 * Lanes];
+    // interleaved output for a chunk, used when writing to separate channel buffers
+    alignas(64) SampleType out[chunkSteps * Lanes];
+    // the column index, incremented each step
+    int pinkIndex = 0;
+    // the row mask, keeps the index inside the rows in use
+    int pinkIndexMask;
+    // used to normalize the noise at the output
+    SampleType pinkNorm;
+
+    // rounds a row value to a multiple of 2^-19, then the sum of up to 16 rows
+    // needs at most 23 bits and every update to the running sum is exact
+    // the offset's lowest bit is 2^-19 in either precision (16 for float, 2^33 for double),
+    // so both round the rows the same way (relies on strict float maths, do not build with -ffast-math)
+    static constexpr SampleType quantizeOffset = sizeof(SampleType) == sizeof(float) ? (SampleType) 16 : (SampleType) 8589934592.0;
+    static Vec quantize (Vec x) {
+        const Vec offset = Vec::broadcast(quantizeOffset);
+        return (x + offset) - offset;
+    }
+    static SampleType quantize (SampleType x) { return (x + quantizeOffset) - quantizeOffset; }
+
+    // in counter mode the random stream is laid out as the initial row values,
+    // rows * Lanes of them, then 2 * Lanes values per step
+    uint64_t getStreamIndex (uint64_t step) const { return (uint64_t) (getRows() + 2 * step) * Lanes; }
+
+    // generates numSteps interleaved steps into dst[step * Lanes + lane]
+    void generateChunk(SampleType* dst, int numSteps) {
+        constexpr int numVecs = Lanes / Vec::size;
+
+        noiseSrc.generate(rnd, numSteps * 2 * Lanes);
+        const Vec norm = Vec::broadcast(pinkNorm);
+        const int mask = pinkIndexMask;
+        int index = pinkIndex;
+
+        // the running sums stay in registers for the whole chunk
+        Vec sum[numVecs];
+        for (int v = 0; v < numVecs; v++)
+            sum[v] = Vec::load(pinkRunSum + v * Vec::size);
+
+        for (int step = 0; step < numSteps; step++) {
+            const float* update = rnd + step * 2 * Lanes;
+            const float* extra = update + Lanes;
+            SampleType* o = dst + step * Lanes;
+
+            index = (index + 1) & mask;
+
+            if (index != 0) {
+                SampleType* row = pinkRows[countTrailingZeros((uint32_t) index)];
+                for (int v = 0; v < numVecs; v++) {
+                    const Vec newRandom = quantize(Vec::loadFloat(update + v * Vec::size));
+                    sum[v] += newRandom - Vec::load(row + v * Vec::size);
+                    newRandom.store(row + v * Vec::size);
+                }
+            }
+
+            for (int v = 0; v < numVecs; v++)
+                ((sum[v] + Vec::loadFloat(extra + v * Vec::size)) * norm).store(o + v * Vec::size);
+        }
+
+        for (int v = 0; v < numVecs; v++)
+            sum[v].store(pinkRunSum + v * Vec::size);
+        pinkIndex = index;
+    }
+
+public:
+    // constructor, 12 rows to match PinkNoise
+    PinkNoiseLanes(int numRows = 12) { setRows(numRows); }
+    PinkNoiseLanes(int numRows, uint64_t seed) : noiseSrc(seed) { setRows(numRows); }
+
+    // restarts every lane from a new seed
+    void setSeed(uint64_t seed) {
+        noiseSrc.setSeed(seed);
+        setRows(getRows());
+    }
+
+    // counter mode makes seek() available, changing mode restarts the stream
+    void setMode(WhiteNoise::Mode mode) {
+        noiseSrc.setMode(mode);
+        setRows(getRows());
+    }
+
+    // jumps to step (sample) number step since the last setRows(), only in counter mode
+    // each row is set to the value it took at its last update before step
+    void seek(uint64_t step) {
+        if (noiseSrc.getMode() != WhiteNoise::Mode::Counter)
+            return;
+
+        const int rows = getRows();
+        for (int lane = 0; lane < Lanes; lane++)
+            pinkRunSum[lane] = 0;
+
+        for (int row = 0; row < rows; row++) {
+            // row is updated by the steps whose index, counted from 1, is an odd multiple of 2^row
+            const uint64_t offset = (uint64_t) 1 << row, period = offset << 1;
+            const uint64_t first = step >= offset ? getStreamIndex(((step - offset) / period) * period + offset - 1)
+                                                  : (uint64_t) row * Lanes;
+            for (int lane = 0; lane < Lanes; lane++) {
+                pinkRows[row][lane] = quantize(noiseSrc.valueAt(first + (uint64_t) lane));
+                pinkRunSum[lane] += pinkRows[row][lane];
+            }
+        }
+
+        pinkIndex = (int) (step & (uint64_t) pinkIndexMask);
+        noiseSrc.seek(getStreamIndex(step));
+    }
+
+    int getRows() const { return countTrailingZeros((uint32_t) pinkIndexMask + 1); }
+
+    // changes the number of rows and reinitializes them with noise, does not allocate
+    void setRows(int newRows) {
+        newRows = std::max(1, std::min(newRows, maxRows));
+        pinkIndex = 0;
+        pinkIndexMask = (1 << newRows) - 1;
+        pinkNorm = (SampleType) 1 / (newRows + 1);
+        noiseSrc.seek(0);
+        for (int row = 0; row < maxRows; row++)
+            for (int lane = 0; lane < Lanes; lane++)
+                pinkRows[row][lane] = (row < newRows) ? quantize(noiseSrc.nextFloat()) : 0;
+        // the running sum starts as the sum of the rows so that the subtraction in each update balances
+        for (int lane = 0; lane < Lanes; lane++) {
+            pinkRunSum[lane] = 0;
+            for (int row = 0; row < newRows; row++)
+                pinkRunSum[lane] += pinkRows[row][lane];
+        }
+    }
+
+    // generates n samples for every lane, interleaved as dst[sample * Lanes + lane]
+    void generateInterleaved(SampleType* dst, int n) {
+        while (n > 0) {
+            const int steps = std::min(n, chunkSteps);
+            generateChunk(dst, steps);
+            dst += steps * Lanes;
+            n -= steps;
+        }
+    }
+
+    // generates n samples into numChannels separate buffers, lane i feeds channels[i]
+    // lanes beyond numChannels are still run so each lane's stream does not depend on the channel count
+    void generate(SampleType* const* channels, int numChannels, int n) {
+        NOISE_TRACE_SCOPE("pink rows");
+        numChannels = std::min(numChannels, Lanes);
+        for (int start = 0; start < n; start += chunkSteps) {
+            const int steps = std::min(n - start, chunkSteps);
+            generateChunk(out, steps);
+            for (int ch = 0; ch < numChannels; ch++) {
+                SampleType* dst = channels[ch] + start;
+                for (int step = 0; step < steps; step++)
+                    dst[step] = out[step * Lanes + ch];
+            }
+        }
+    }
+};
+
+template <typename SampleType = float>
 class BrownNoise {
+public:
+    // Streaming runs the leaky integrator one sample at a time and scales it by its known
+    // standard deviation, so every sample costs the same and the state is a single value.
+    // Buffered is the original generator, which integrates and min/max normalizes a whole
+    // buffer at a time, kept for output compatibility.
+    enum class Mode { Streaming, Buffered };
+
 private:
-    // random noise generator from the JUCE library
-    juce::Random noiseSrc;
+    // vectorized random noise generator, see WhiteNoise.h
+    WhiteNoise noiseSrc;
     // buffer vector of unormalized brown noise
     // (vector instead of queue so that we can use the .begin() and .end() functions)
-    std::vector<float> nB, nBn;
+    std::vector<SampleType> nB, nBn;
     // iterator for the brown noise vectors
-    std::vector<float>::iterator itB;
+    typename std::vector<SampleType>::iterator itB;
     // max and min values of the brown noise buffer, used in noramlization
-    float maxB, minB;
+    SampleType maxB, minB;
     // op: raw output sample of brown noise gen, ip: input to sample buffer function
-    float op;
+    SampleType op;
     int bLength;
     // leaky integrator constant http://sepwww.stanford.edu/sep/prof/pvi/zp/paper_html/node2.html
-    float a = 0.95;
+    SampleType a = (SampleType) 0.95;
+
+    // which of the two generators is running
+    Mode mode;
+    // streaming mode: current (unnormalized) integrator output
+    SampleType level = 0;
+    // streaming mode: maps the integrator output onto the same range as the buffered mode
+    SampleType streamScale;
+    // number of random values drawn at a time in streaming mode
+    static constexpr int streamChunk = 64;
+
+    void updateStreamScale() { streamScale = getStreamScale(a); }
+
+    // scales an integrator output and keeps it inside [-1, 1] for the rare sample past the headroom
+    SampleType normalize(SampleType x) const { return std::max((SampleType) -1, std::min((SampleType) 1, x * streamScale)); }
     
 public:
-    // constructor
-    BrownNoise(int bL = 20000) {
-        bLength = bL;
-        // intiaize first sample with white noise
-        fillBuffer(noiseSrc.nextFloat());
-        itB = nBn.begin();
+    // The integrator input 2u - 1 is uniform on [-1, 1), with variance 1/3, so the output
+    // variance settles at (1/3) / (1 - a^2). Put sigmaHeadroom standard deviations at the
+    // buffered mode's 0.8 peak, which lands the two modes at about the same loudness.
+    static constexpr float sigmaHeadroom = 4.0f;
+    static SampleType getStreamScale(SampleType a) {
+        return (SampleType) 0.8 / (sigmaHeadroom * std::sqrt(((SampleType) 1 / 3) / (1 - a * a)));
+    }
+
+    // constructor, bL is the buffer length used in buffered mode
+    BrownNoise(Mode m = Mode::Streaming, int bL = 20000) : bLength(bL), mode(m) {
+        updateStreamScale();
+        if (mode == Mode::Buffered) {
+            // intiaize first sample with white noise
+            fillBuffer(noiseSrc.nextFloat());
+            itB = nBn.begin();
+        }
+        else {
+            // start the integrator somewhere in its steady state range rather than at zero
+            level = (2 * noiseSrc.nextFloat() - 1) / std::sqrt(1 - a * a);
+        }
+    }
+
+    Mode getMode() const { return mode; }
+
+    // switches generator, carrying the integrator state over so there is no jump in level
+    // switching to buffered mode allocates, so do not call this from the audio thread
+    void setMode(Mode newMode) {
+        if (newMode == mode)
+            return;
+        if (newMode == Mode::Buffered) {
+            fillBuffer(level);
+            itB = nBn.begin();
+        }
+        else {
+            // pick up from the unnormalized sample that matches the next buffered output
+            level = nB.empty() ? 0 : nB[(size_t) std::min<std::ptrdiff_t>(itB - nBn.begin(), (std::ptrdiff_t) nB.size() - 1)];
+            nB = {}; nBn = {};
+            itB = nBn.begin();
+        }
+        mode = newMode;
     }
     
     // input is the first sample, or seed sample
-    void fillBuffer(float input) {
+    void fillBuffer(SampleType input) {
+        NOISE_TRACE_SCOPE("brown refill");
         // clear contents
         nB.clear(); nBn.clear();
         // add first sample to buffer
@@ -167,7 +484,12 @@ public:
         }
     }
     
-    float generate() {
+    SampleType generate() {
+        if (mode == Mode::Streaming) {
+            level = a * level + 2 * noiseSrc.nextFloat() - 1; // leaky integration
+            return normalize(level);
+        }
+
         // check to see if you hit the end of the buffer, and if yes refill
         if (!(itB < nBn.end())) {
             // use last used sample from unormalized buffer for start of new buffer
@@ -179,77 +501,687 @@ public:
         itB++;
         return op;
     }
+
+    // generates a block of n brown noise samples into dst
+    void generate(SampleType* dst, int n) {
+        NOISE_TRACE_SCOPE("brown");
+        if (mode == Mode::Streaming) {
+            generateStreaming(dst, n);
+            return;
+        }
+
+        // copies straight out of the normalized buffer, refilling whenever it runs dry
+        while (n > 0) {
+            if (!(itB < nBn.end())) {
+                fillBuffer(nB.back() + noiseSrc.nextFloat());
+                itB = nBn.begin();
+            }
+            // copy as many samples as are left in the buffer, up to n
+            int count = (int) std::min<std::ptrdiff_t>(n, nBn.end() - itB);
+            std::copy(itB, itB + count, dst);
+            itB += count;
+            dst += count;
+            n -= count;
+        }
+    }
+
+private:
+    // streaming block generator, the integrator state is held in a local for the whole block
+    void generateStreaming(SampleType* dst, int n) {
+        float rnd[streamChunk];
+        SampleType y = level;
+        const SampleType k = a;
+        const SampleType scale = streamScale;
+
+        while (n > 0) {
+            const int count = std::min(n, streamChunk);
+            noiseSrc.generate(rnd, count);
+            for (int s = 0; s < count; s++) {
+                y = k * y + 2 * rnd[s] - 1; // leaky integration
+                dst[s] = std::max((SampleType) -1, std::min((SampleType) 1, y * scale));
+            }
+            dst += count;
+            n -= count;
+        }
+
+        level = y;
+    }
+};
+
+// Runs Lanes streaming brown noise generators side by side, one per channel or voice.
+// Each lane is the leaky integrator from BrownNoise's streaming mode; the lanes are
+// independent, so the integrator's serial dependency is spread across a vector.
+template <int Lanes, typename SampleType = float>
+class BrownNoiseLanes {
+    static_assert(Lanes % SimdVec<SampleType>::size == 0, "BrownNoiseLanes needs a whole number of vectors");
+
+    // number of steps generated per pass through the random scratch buffer
+    static constexpr int chunkSteps = 32;
+
+public:
+    // steps seek() runs the integrator for before the target, a^512 is around 4e-12 and
+    // a^1024 around 2e-23, so by then the restarted integrator has the same state as one
+    // that ran from the start in float and double respectively
+    static constexpr int settleSteps = sizeof(SampleType) == sizeof(float) ? 512 : 1024;
+
+private:
+    using Vec = SimdVec<SampleType>;
+
+    // random noise generator shared by all lanes
+    WhiteNoise noiseSrc;
+    // integrator output for each lane
+    alignas(64) SampleType level[Lanes];
+    // random values for a chunk, one per lane per step
+    alignas(64) float rnd[chunkSteps * Lanes];
+    // interleaved output for a chunk, used when writing to separate channel buffers
+    alignas(64) SampleType out[chunkSteps * Lanes];
+    // leaky integrator constant, the same as BrownNoise
+    SampleType a = (SampleType) 0.95;
+    // maps the integrator output onto [-1, 1], see BrownNoise::getStreamScale
+    SampleType streamScale = BrownNoise<SampleType>::getStreamScale((SampleType) 0.95);
+
+    void generateChunk(SampleType* dst, int numSteps) {
+        constexpr int numVecs = Lanes / Vec::size;
+
+        noiseSrc.generate(rnd, numSteps * Lanes);
+        const Vec k = Vec::broadcast(a), two = Vec::broadcast(2), one = Vec::broadcast(1);
+        const Vec scale = Vec::broadcast(streamScale), lo = Vec::broadcast(-1);
+
+        Vec y[numVecs];
+        for (int v = 0; v < numVecs; v++)
+            y[v] = Vec::load(level + v * Vec::size);
+
+        for (int step = 0; step < numSteps; step++) {
+            for (int v = 0; v < numVecs; v++) {
+                const int offset = step * Lanes + v * Vec::size;
+                y[v] = k * y[v] + (two * Vec::loadFloat(rnd + offset) - one); // leaky integration
+                Vec::max(lo, Vec::min(one, y[v] * scale)).store(dst + offset);
+            }
+        }
+
+        for (int v = 0; v < numVecs; v++)
+            y[v].store(level + v * Vec::size);
+    }
+
+public:
+    BrownNoiseLanes() { reset(); }
+    explicit BrownNoiseLanes(uint64_t seed) : noiseSrc(seed) { reset(); }
+
+    // restarts every lane from a new seed
+    void setSeed(uint64_t seed) {
+        noiseSrc.setSeed(seed);
+        reset();
+    }
+
+    // counter mode makes seek() available, changing mode restarts the stream
+    void setMode(WhiteNoise::Mode mode) {
+        noiseSrc.setMode(mode);
+        reset();
+    }
+
+    // jumps to step (sample) number step since the last reset(), only in counter mode
+    // in counter mode the stream is the Lanes starting levels followed by Lanes values per step
+    void seek(uint64_t step) {
+        if (noiseSrc.getMode() != WhiteNoise::Mode::Counter)
+            return;
+
+        uint64_t settle = step;
+        if (step <= (uint64_t) settleSteps) {
+            reset();
+        }
+        else {
+            settle = settleSteps;
+            for (int lane = 0; lane < Lanes; lane++)
+                level[lane] = 0;
+            noiseSrc.seek((step - settle + 1) * Lanes);
+        }
+
+        for (int done = 0; done < (int) settle; done += chunkSteps)
+            generateChunk(out, std::min(chunkSteps, (int) settle - done));
+    }
+
+    // starts each integrator somewhere in its steady state range rather than at zero
+    void reset() {
+        noiseSrc.seek(0);
+        for (int lane = 0; lane < Lanes; lane++)
+            level[lane] = (2 * noiseSrc.nextFloat() - 1) / std::sqrt(1 - a * a);
+    }
+
+    // generates n samples for every lane, interleaved as dst[sample * Lanes + lane]
+    void generateInterleaved(SampleType* dst, int n) {
+        while (n > 0) {
+            const int steps = std::min(n, chunkSteps);
+            generateChunk(dst, steps);
+            dst += steps * Lanes;
+            n -= steps;
+        }
+    }
+
+    // generates n samples into numChannels separate buffers, lane i feeds channels[i]
+    void generate(SampleType* const* channels, int numChannels, int n) {
+        NOISE_TRACE_SCOPE("brown integrate");
+        numChannels = std::min(numChannels, Lanes);
+        for (int start = 0; start < n; start += chunkSteps) {
+            const int steps = std::min(n - start, chunkSteps);
+            generateChunk(out, steps);
+            for (int ch = 0; ch < numChannels; ch++) {
+                SampleType* dst = channels[ch] + start;
+                for (int step = 0; step < steps; step++)
+                    dst[step] = out[step * Lanes + ch];
+            }
+        }
+    }
 };
 
+// Moving average/smoothing filter, built as a CIC style integrator and comb
+// https://zipcpu.com/dsp/2017/10/16/boxcar.html
+// Samples are converted to fixed point before they are accumulated, so the
+// running sum is exact and does not pick up rounding drift however long it runs.
+// The history lives in a power-of-two ring buffer sized up front, so changing the
+// length up to the capacity never allocates and is safe on the audio thread.
+// Float samples are held with 24 fractional bits in an int32; double samples get
+// 36 fractional bits in an int64, which still leaves room to sum 65536 of them.
+template <typename SampleType = float>
+class SmoothingFilter {
+    // runs the same fixed point arithmetic across channels
+    template <typename> friend class NoiseFilterLanes;
+
+public:
+    // default ring capacity, the longest smoothing length available without calling setMaxLength()
+    static constexpr int defaultMaxLength = 1024;
+
+private:
+    static constexpr bool isFloat = sizeof(SampleType) == sizeof(float);
+    // fixed point sample type
+    using Fixed = typename std::conditional<isFloat, int32_t, int64_t>::type;
+    // fixed point scale, 24 fractional bits matches the float mantissa for inputs in [-1, 1]
+    static constexpr double fixedScale = isFloat ? 16777216.0 : 68719476736.0;
+    // inputs are clamped to this magnitude so the fixed point value always fits Fixed
+    static constexpr SampleType inputLimit = 127;
+
+    // mem - ring buffer of past fixed point inputs, x[n - N] is read just before x[n] is written
+    std::vector<Fixed> mem;
+    // ring index mask, mem.size() - 1
+    int mask = 0;
+    // write position in the ring
+    int pos = 0;
+    // N - smooth length
+    int N = 1;
+    // count - samples seen since the last reset, the filter passes the input through until it reaches N
+    int count = 0;
+    // acc - exact sum of the last N fixed point inputs
+    int64_t acc = 0;
+    // 1 / (fixedScale * N), turns the accumulator back into an average
+    double outScale;
+
+    // truncates rather than rounds, a single instruction; the sum stays exact either way
+    // because the same value that is added is the one that is later subtracted
+    static Fixed toFixed (SampleType x) {
+        x = std::max(-inputLimit, std::min(inputLimit, x));
+        return (Fixed) (x * (SampleType) fixedScale);
+    }
+
+public:
+    // constructor
+    SmoothingFilter(int length = 4, int maxLength = defaultMaxLength) {
+        setMaxLength(maxLength);
+        setLength(length);
+    }
+
+    // resizes the ring to the next power of two at or above maxLength
+    // this allocates, so call it from prepareToPlay or the message thread
+    void setMaxLength (int maxLength) {
+        int capacity = 1;
+        while (capacity < maxLength)
+            capacity <<= 1;
+        mem.assign((size_t) capacity, 0);
+        mask = capacity - 1;
+        setLength(N);
+    }
+
+    int getMaxLength() const { return mask + 1; }
+    int getLength() const { return N; }
+
+    // changes the smoothing length and restarts the filter, clamped to the ring capacity
+    // does not allocate
+    void setLength (int length) {
+        N = std::max(1, std::min(length, mask + 1));
+        outScale = 1.0 / (fixedScale * N);
+        reset();
+    }
+
+    // clears the history
+    void reset() {
+        std::fill(mem.begin(), mem.end(), 0);
+        pos = 0;
+        count = 0;
+        acc = 0;
+    }
+
+    // filters a single sample
+    SampleType process (SampleType ip) {
+        const Fixed x = toFixed(ip);
+        acc += x - mem[(size_t) ((pos - N) & mask)];
+        mem[(size_t) pos] = x;
+        pos = (pos + 1) & mask;
+        // init
+        if (count < N) {
+            count++;
+            return ip;
+        }
+        // return avg/N
+        return (SampleType) ((double) acc * outScale);
+    }
+
+    // filters n samples in place
+    void process (SampleType* buf, int n) {
+        Fixed* ring = mem.data();
+        int64_t sum = acc;
+        int w = pos;
+        const int m = mask, len = N;
+        const double scale = outScale;
+        int s = 0;
+
+        // init, the first N samples after a reset pass straight through while the history fills
+        for (; s < n && count < len; s++, count++) {
+            const Fixed x = toFixed(buf[s]);
+            sum += x - ring[(w - len) & m];
+            ring[w] = x;
+            w = (w + 1) & m;
+        }
+
+        for (; s < n; s++) {
+            const Fixed x = toFixed(buf[s]);
+            sum += x - ring[(w - len) & m];
+            ring[w] = x;
+            w = (w + 1) & m;
+            buf[s] = (SampleType) ((double) sum * scale);
+        }
+
+        acc = sum;
+        pos = w;
+    }
+};
+
+template <typename SampleType = float>
 class NoiseFilter {
 private:
     // DC blocker variables
-    float R;
-    float y = 0, xm1 = 0, ym1 = 0;
-    
-    // smoothing filter variables
-    // N - smooth length
-    // i - counter for initialization
-    int N, i = 0;
-    // opS - output of smoothing filter
-    // sub - subsitution : x[n] - x[n - N]
-    // acc - accumulator
-    float sub, acc;
-    // mem - memory for x[i - N] values
-    std::queue<float> mem;
+    SampleType R;
+    SampleType y = 0, xm1 = 0, ym1 = 0;
     
-    // use to clear memory queue on changes to N
-    void clear( std::queue<float> &q )
-    {
-       std::queue<float> empty;
-       std::swap( q, empty );
-    }
+    // smoothing filter
+    SmoothingFilter<SampleType> smoother;
     
 public:
     // constructor
-    NoiseFilter(float R_in = 0.99, int N_in = 4) : R(R_in), N(N_in) {}
+    NoiseFilter(SampleType R_in = (SampleType) 0.99, int N_in = 4) : R(R_in), smoother(N_in) {}
     
     // DC blocking filter
     // https://www.dsprelated.com/freebooks/filters/DC_Blocker.html
-    float dc_blocking_filter (float ip) {
+    SampleType dc_blocking_filter (SampleType ip) {
         y = ip - xm1 + R * ym1;
         xm1 = ip;
         ym1 = y;
         return y;
     }
     
-    // moving average/smoothing filter
-    // https://zipcpu.com/dsp/2017/10/16/boxcar.html
-    float smoothing_filter (float ip) {
-        // init
-        if (i < N) {
-            mem.push(ip); // load memory buffer
-            //opS = ip;
-            i++;
-            return ip;
-        }
-        else {
-            // update sample memory buffer
-            mem.push(ip);
-            // filter
-            //sub = ip - mem;
-            sub = ip - mem.front();
-            acc += sub;
-            // trim sample memory buffer
-            mem.pop();
+    // moving average/smoothing filter, see SmoothingFilter
+    SampleType smoothing_filter (SampleType ip) { return smoother.process(ip); }
+
+    // block versions of the filters, these process buf in place
+    // DC blocking filter over n samples, state is kept in locals for the block
+    void dc_blocking_filter (SampleType* buf, int n) {
+        SampleType x1 = xm1, y1 = ym1;
+        const SampleType r = R;
+        for (int s = 0; s < n; s++) {
+            SampleType x0 = buf[s];
+            y1 = x0 - x1 + r * y1;
+            x1 = x0;
+            buf[s] = y1;
         }
-        // return avg/N
-        return acc/N;
+        xm1 = x1; ym1 = y1; y = y1;
+    }
+
+    // moving average/smoothing filter over n samples
+    void smoothing_filter (SampleType* buf, int n) { smoother.process(buf, n); }
+
+    // clears both filters
+    void reset() {
+        y = xm1 = ym1 = 0;
+        smoother.reset();
+    }
+
+    // samples to run the filters for after a reset() before their state matches
+    // what it would be had they run all along: the smoothing length, which is
+    // exact, plus the time the DC blocker takes for R^n to fall below 2^-30, or 2^-60 in double
+    int getSettleLength (bool smooth, bool dcBlock) const {
+        const double bits = sizeof(SampleType) == sizeof(float) ? 30.0 : 60.0;
+        int length = smooth ? smoother.getLength() : 0;
+        if (dcBlock)
+            length += (int) std::min(65536.0, std::ceil(-bits * std::log(2.0) / std::log((double) R)));
+        return length;
+    }
+
+    // runs the enabled filter stages over a block, smoothing first then DC blocking,
+    // in the same order as the per-sample processing
+    void process (SampleType* buf, int n, bool smooth, bool dcBlock) {
+        if (smooth)
+            smoothing_filter(buf, n);
+        if (dcBlock)
+            dc_blocking_filter(buf, n);
     }
     
     // sets for UI control
-    void setDCfiltConst (float sliderVal) { R = (sliderVal < 1.0) ? sliderVal : R; } // if ip < 1, pass to R, else leave it
-    void setSmoothLength (int sliderVal) {
-        N = sliderVal;
-        // reset memory buffer counter
-        i = 0;
-        // clear the memory buffer
-        clear(mem);
-    }
+    void setDCfiltConst (SampleType sliderVal) { R = (sliderVal < 1.0) ? sliderVal : R; } // if ip < 1, pass to R, else leave it
+    // changes the smoothing length without allocating, up to getMaxSmoothLength()
+    void setSmoothLength (int sliderVal) { smoother.setLength(sliderVal); }
+    // sizes the smoothing history, allocates so keep it off the audio thread
+    void setMaxSmoothLength (int maxLength) { smoother.setMaxLength(maxLength); }
+    int getMaxSmoothLength() const { return smoother.getMaxLength(); }
     
 };
+
+// NoiseFilter for a whole bus, laid out as a structure of arrays: the DC blocker's
+// state for every channel sits in one contiguous array, the smoothing rings are
+// stored [slot][lane] so one slot of every lane is a single load, and the channels
+// are filtered lanes at a time. Each channel's filter is a chain of one sample
+// depending on the last, which a single channel cannot run any faster than its
+// latency; side by side the lanes are independent and fill the vector units.
+// The output is exactly what a NoiseFilter per channel would give.
+// Every channel shares the filter settings and the smoothing position, so the
+// channels move on together; any left out of a block lose their place until the
+// next reset().
+template <typename SampleType = float>
+class NoiseFilterLanes {
+public:
+    // channels filtered together, a multiple of every SimdVec size
+    static constexpr int lanes = 8;
+
+private:
+    using Vec = SimdVec<SampleType>;
+    using Smoother = SmoothingFilter<SampleType>;
+    using Fixed = typename Smoother::Fixed;
+    static constexpr int vecsPerGroup = lanes / Vec::size;
+    // samples interleaved at a time
+    static constexpr int frameSize = 256;
+
+    // per channel state for one group of lanes
+    struct alignas(64) Group {
+        // DC blocker, x[n - 1] and y[n - 1]
+        SampleType x1[lanes] = {}, y1[lanes] = {};
+        // smoothing, exact sum of the last N fixed point inputs
+        int64_t acc[lanes] = {};
+    };
+    std::vector<Group> groups;
+    // smoothing history, ring[(group * capacity + slot) * lanes + lane]
+    std::vector<Fixed> ring;
+
+    // DC blocker pole, shared by every channel, ramped linearly when it changes
+    ParameterRamp pole { ParameterRamp::Shape::Linear, 0.99 };
+    // smoothing settings and position, shared by every channel, as in SmoothingFilter
+    int mask = 0, pos = 0, N = 4, count = 0;
+    double outScale = 1.0;
+    // smoothing length glide, N moves from glideFrom to glideTo over glideLength samples, by at
+    // most one every sample; glideDone counts the samples the glide has been advanced through
+    int glideFrom = 4, glideTo = 4, glideLength = 0, glideDone = 0;
+
+    int getCapacity() const { return mask + 1; }
+
+    // the smoothing length once the glide has run for done samples
+    int getGlideLength(int done) const {
+        return glideFrom + (int) ((int64_t) (glideTo - glideFrom) * std::min(done, glideLength) / glideLength);
+    }
+
+    // smooths n interleaved samples that start offset samples after the current position
+    void smooth(Group& group, Fixed* NOISE_RESTRICT history, SampleType* NOISE_RESTRICT frame, int offset, int n) const {
+        if (glideDone < glideLength)
+            smoothSamples<true>(group, history, frame, offset, n);
+        else
+            smoothSamples<false>(group, history, frame, offset, n);
+    }
+
+    // while Gliding the length moves on before every sample, adding the next older sample of the
+    // history to the running sums for a sample longer or taking the oldest away for one shorter,
+    // so the sums stay exact; advance() then only has to catch N up with where the glide got to
+    template <bool Gliding>
+    void smoothSamples(Group& group, Fixed* NOISE_RESTRICT history, SampleType* NOISE_RESTRICT frame, int offset, int n) const {
+        const int m = mask;
+        int len = Gliding ? getGlideLength(glideDone + offset) : N;
+        double scale = Gliding ? 1.0 / (Smoother::fixedScale * len) : outScale;
+        int w = (pos + offset) & m, seen = std::min(len, count + offset);
+        for (int s = 0; s < n; s++, w = (w + 1) & m) {
+            if (Gliding) {
+                const int next = getGlideLength(glideDone + offset + s + 1);
+                if (next > len) {
+                    const Fixed* NOISE_RESTRICT older = history + ((w - next) & m) * lanes;
+                    for (int lane = 0; lane < lanes; lane++)
+                        group.acc[lane] += older[lane];
+                }
+                else if (next < len) {
+                    const Fixed* NOISE_RESTRICT oldest = history + ((w - len) & m) * lanes;
+                    for (int lane = 0; lane < lanes; lane++)
+                        group.acc[lane] -= oldest[lane];
+                }
+                if (next != len) {
+                    len = next;
+                    scale = 1.0 / (Smoother::fixedScale * len);
+                    seen = std::min(len, count + offset + s);
+                }
+            }
+            const Fixed* NOISE_RESTRICT old = history + ((w - len) & m) * lanes;
+            Fixed* NOISE_RESTRICT slot = history + w * lanes;
+            SampleType* NOISE_RESTRICT x = frame + s * lanes;
+            // the first N samples after a reset pass straight through while the history fills
+            const bool filling = seen < len;
+            seen += filling ? 1 : 0;
+            for (int lane = 0; lane < lanes; lane++) {
+                const Fixed fixed = Smoother::toFixed(x[lane]);
+                group.acc[lane] += fixed - old[lane];
+                slot[lane] = fixed;
+                if (! filling)
+                    x[lane] = (SampleType) ((double) group.acc[lane] * scale);
+            }
+        }
+    }
+
+    // DC blocks n interleaved samples that start offset samples after the current position
+    void blockDC(Group& group, SampleType* frame, int offset, int n) const {
+        Vec x1[vecsPerGroup], y1[vecsPerGroup];
+        for (int v = 0; v < vecsPerGroup; v++) {
+            x1[v] = Vec::load(group.x1 + v * Vec::size);
+            y1[v] = Vec::load(group.y1 + v * Vec::size);
+        }
+        auto filter = [&](SampleType* x, Vec r) {
+            for (int v = 0; v < vecsPerGroup; v++) {
+                const Vec x0 = Vec::load(x + v * Vec::size);
+                y1[v] = x0 - x1[v] + r * y1[v];
+                x1[v] = x0;
+                y1[v].store(x + v * Vec::size);
+            }
+        };
+        // while the pole ramps it moves on every sample, then holds at its target
+        const int ramped = std::max(0, std::min(n, pole.getRemaining() - offset));
+        if (ramped > 0) {
+            const double r0 = pole.getValueAfter(offset), dr = (pole.getTarget() - r0) / (pole.getRemaining() - offset);
+            for (int s = 0; s < ramped; s++)
+                filter(frame + s * lanes, Vec::broadcast((SampleType) (r0 + dr * (s + 1))));
+        }
+        const Vec r = Vec::broadcast((SampleType) pole.getTarget());
+        for (int s = ramped; s < n; s++)
+            filter(frame + s * lanes, r);
+        for (int v = 0; v < vecsPerGroup; v++) {
+            x1[v].store(group.x1 + v * Vec::size);
+            y1[v].store(group.y1 + v * Vec::size);
+        }
+    }
+
+public:
+    NoiseFilterLanes(int numChannels = 0) {
+        setMaxSmoothLength(Smoother::defaultMaxLength);
+        prepare(numChannels);
+    }
+
+    // sizes the state for numChannels channels and clears it, allocates
+    void prepare(int numChannels) {
+        groups.assign((size_t) ((std::max(0, numChannels) + lanes - 1) / lanes), Group());
+        ring.assign(groups.size() * (size_t) getCapacity() * lanes, 0);
+        reset();
+    }
+    void release() {
+        groups = {};
+        ring = {};
+    }
+
+    int getNumChannels() const { return (int) groups.size() * lanes; }
+
+    // clears both filters on every channel, and finishes any ramp or glide
+    void reset() {
+        for (auto& group : groups)
+            group = Group();
+        pole.setValue(pole.getTarget());
+        if (glideDone < glideLength)
+            setSmoothLength(glideTo);
+        resetSmoothing();
+    }
+
+    // clears both filters on one channel, for a channel that starts over on its own, e.g. a new voice
+    // its smoothing fades in from silence rather than passing straight through while the history fills
+    void resetChannel(int channel) {
+        if (channel < 0 || channel >= getNumChannels())
+            return;
+        const int g = channel / lanes, lane = channel % lanes;
+        Group& group = groups[(size_t) g];
+        group.x1[lane] = group.y1[lane] = 0;
+        group.acc[lane] = 0;
+        Fixed* history = ring.data() + (size_t) g * (size_t) getCapacity() * lanes;
+        for (int slot = 0; slot < getCapacity(); slot++)
+            history[slot * lanes + lane] = 0;
+    }
+
+    // the same as NoiseFilter::getSettleLength
+    int getSettleLength(bool smoothing, bool dcBlock) const {
+        const double bits = sizeof(SampleType) == sizeof(float) ? 30.0 : 60.0;
+        int length = smoothing ? N : 0;
+        if (dcBlock)
+            length += (int) std::min(65536.0, std::ceil(-bits * std::log(2.0) / std::log(pole.getValue())));
+        return length;
+    }
+
+    // filters n samples of channels first to first + numChannels - 1 in place, buf[0] being
+    // channel first, smoothing then DC blocking as NoiseFilter::process does; first is a multiple
+    // of lanes. Call advance() once every channel has had its n samples
+    void processGroups(SampleType* const* buf, int first, int numChannels, int n, bool smoothing, bool dcBlock) {
+        if (! (smoothing || dcBlock) || n <= 0)
+            return;
+        numChannels = std::min(numChannels, getNumChannels() - first);
+        alignas(64) SampleType frame[frameSize * lanes];
+
+        for (int start = 0; start < n; start += frameSize) {
+            const int length = std::min(frameSize, n - start);
+            for (int offset = 0; offset < numChannels; offset += lanes) {
+                const int g = (first + offset) / lanes;
+                const int count = std::min(lanes, numChannels - offset);
+                for (int lane = 0; lane < lanes; lane++) {
+                    if (lane < count) {
+                        const SampleType* src = buf[offset + lane] + start;
+                        for (int s = 0; s < length; s++)
+                            frame[s * lanes + lane] = src[s];
+                    }
+                    else {
+                        for (int s = 0; s < length; s++)
+                            frame[s * lanes + lane] = 0;
+                    }
+                }
+
+                if (smoothing)
+                    smooth(groups[(size_t) g], ring.data() + (size_t) g * (size_t) getCapacity() * lanes, frame, start, length);
+                if (dcBlock)
+                    blockDC(groups[(size_t) g], frame, start, length);
+
+                for (int lane = 0; lane < count; lane++) {
+                    SampleType* dst = buf[offset + lane] + start;
+                    for (int s = 0; s < length; s++)
+                        dst[s] = frame[s * lanes + lane];
+                }
+            }
+        }
+    }
+
+    // moves the smoothing position and any ramps on once every group has been processed for
+    // n samples, kept apart from processGroups() so the groups can be split between threads
+    void advance(int n, bool smoothing, bool dcBlock) {
+        if (dcBlock)
+            pole.skip(n);
+        if (smoothing) {
+            pos = (pos + n) & mask;
+            // counted up to the whole history rather than N, so a longer N can glide into it
+            count = std::min(getCapacity(), count + n);
+        }
+        if (glideDone < glideLength) {
+            if (! smoothing) {
+                // the history isn't being kept, so there is nothing to glide through
+                setSmoothLength(glideTo);
+                return;
+            }
+            glideDone = std::min(glideLength, glideDone + n);
+            N = getGlideLength(glideDone);
+            outScale = 1.0 / (Smoother::fixedScale * N);
+        }
+    }
+
+    // filters n samples of the first numChannels channels in place
+    void process(SampleType* const* buf, int numChannels, int n, bool smoothing, bool dcBlock) {
+        processGroups(buf, 0, numChannels, n, smoothing, dcBlock);
+        advance(n, smoothing, dcBlock);
+    }
+
+    // sets for UI control, as NoiseFilter's; with a rampLength the pole moves there linearly
+    // over that many samples rather than at once
+    void setDCfiltConst(SampleType sliderVal, int rampLength = 0) {
+        if (sliderVal < 1.0)
+            pole.setTarget((double) sliderVal, rampLength);
+    }
+    // changes the smoothing length and restarts the smoothing, without allocating
+    void setSmoothLength(int sliderVal) {
+        N = glideFrom = glideTo = std::max(1, std::min(sliderVal, getCapacity()));
+        glideLength = glideDone = 0;
+        outScale = 1.0 / (Smoother::fixedScale * N);
+        resetSmoothing();
+    }
+    // moves the smoothing length to sliderVal over glideSamples samples, or over as many samples
+    // as it has lengths to travel if that is more, so it moves by no more than one every sample;
+    // the history is kept so the output carries on rather than restarting
+    void glideSmoothLength(int sliderVal, int glideSamples) {
+        const int target = std::max(1, std::min(sliderVal, getCapacity()));
+        if (target == glideTo)
+            return;
+        if (glideSamples <= 0) {
+            setSmoothLength(target);
+            return;
+        }
+        glideFrom = N;
+        glideTo = target;
+        glideLength = std::max(glideSamples, std::abs(target - N));
+        glideDone = 0;
+    }
+    // sizes the smoothing rings, allocates so keep it off the audio thread
+    void setMaxSmoothLength(int maxLength) {
+        int capacity = 1;
+        while (capacity < maxLength)
+            capacity <<= 1;
+        mask = capacity - 1;
+        ring.assign(groups.size() * (size_t) capacity * lanes, 0);
+        setSmoothLength(N);
+    }
+    int getMaxSmoothLength() const { return getCapacity(); }
+
+private:
+    void resetSmoothing() {
+        std::fill(ring.begin(), ring.end(), 0);
+        for (auto& group : groups)
+            std::fill(std::begin(group.acc), std::end(group.acc), 0);
+        pos = 0;
+        count = 0;
+    }
+};
@@ -0,0 +1,449 @@
+/*
+  ==============================================================================
+
+    NoiseSynth.h
+    Created: 19 Oct 2026 6:40:12pm
+    Author:  John McRae
+
+    A polyphonic noise instrument for bursts played from MIDI: snare
+    layers, wind, test stimuli.
+
+    - Voices -
+
+    There is a fixed pool of 128 voices, all allocated by prepare(). Each
+    voice has its own noise generator, its own smoothing and DC filters
+    and its own ADSR envelope, and is scaled by its note's velocity.
+    Every voice is mixed equally into every channel.
+
+    The voices are laid out like MultiChannelNoise's channels, in groups
+    of eight: pink and brown voices are lanes of PinkNoiseLanes /
+    BrownNoiseLanes, white voices have a WhiteNoise each, and the filters
+    are one NoiseFilterLanes with a lane per voice. A group is only
+    generated and filtered while at least one of its voices is sounding,
+    so idle voices cost nothing. A new note takes the lowest free voice,
+    which keeps the sounding voices packed into as few groups as
+    possible. With every voice busy the oldest one is taken over, the
+    oldest of those that are releasing if there are any; its envelope
+    starts its attack from wherever it was, so there is no click.
+
+    Coloured noise needs an FFT per stream, too much for a voice, so
+    coloured voices play pink noise instead.
+
+    - Envelope -
+
+    The envelope is linear in every stage: the attack rises from 0 to 1
+    in the attack time, the decay falls from 1 to the sustain level in
+    the decay time, and the release falls to 0 in the release time from
+    wherever the note was let go. A voice is freed when its release
+    reaches 0, or straight after its decay when the sustain level is 0,
+    so drum hits don't wait for their note off. Each stage is written out as one ramp, so a voice's
+    envelope costs a few multiplies per sample.
+
+    - Timing -
+
+    render() plays everything up to the next event, so calling it up to
+    each MIDI event's sample and then noteOn() / noteOff() makes every
+    note start and stop on its exact sample. Nothing in noteOn(),
+    noteOff() or render() allocates or locks.
+
+    The voices' streams only move on while they are heard, so the output
+    depends on what has been played since the last reset(). The
+    processor resets the synth whenever the play head jumps, so a bounce
+    from the same point with the same MIDI gives the same samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "NoiseSource.h"
+#include "MultiChannelNoise.h"
+#include "WhiteDistribution.h"
+
+template <typename SampleType = float>
+class NoiseSynth {
+public:
+    // voices in the pool
+    static constexpr int maxVoices = 128;
+    // voices generated and filtered together
+    static constexpr int lanesPerGroup = 8;
+    static constexpr int numGroups = maxVoices / lanesPerGroup;
+    // largest block render() works on in one go, longer blocks are split
+    static constexpr int chunkSize = 256;
+
+private:
+    static_assert(NoiseFilterLanes<SampleType>::lanes == lanesPerGroup, "the filter groups line up with the voice groups");
+
+    enum class Stage { Idle, Attack, Decay, Sustain, Release };
+
+    struct Voice {
+        Stage stage = Stage::Idle;
+        // envelope level before velocity
+        SampleType level = 0;
+        // velocity gain, 0 to 1
+        SampleType gain = 0;
+        // fall per sample once released
+        SampleType releaseStep = 0;
+        int note = -1, channel = 0;
+        // when the note started, for picking the oldest voice to take over
+        uint64_t age = 0;
+        // index of the next sample of the voice's white noise
+        uint64_t whitePosition = 0;
+    };
+    Voice voices[maxVoices];
+    // voices that are sounding in each group, a bit per lane
+    uint32_t activeLanes[numGroups] = {};
+    // notes started since the last reset, the age of the next one
+    uint64_t numNotes = 0;
+
+    // every voice's generator, voice v is lane (v % lanesPerGroup) of group (v / lanesPerGroup)
+    std::vector<WhiteNoise> whiteVoices;
+    std::vector<PinkNoiseLanes<lanesPerGroup, SampleType>> pinkGroups;
+    std::vector<BrownNoiseLanes<lanesPerGroup, SampleType>> brownGroups;
+    WhiteDistribution distribution = WhiteDistribution::Offset;
+    // the smoothing and DC filters of every voice
+    NoiseFilterLanes<SampleType> filters;
+    // a chunk of noise for each voice
+    std::vector<SampleType> scratch;
+    // every voice summed, one voice's envelope, and the level while it ramps, for the current chunk
+    alignas(64) SampleType mix[chunkSize];
+    alignas(64) SampleType envelope[chunkSize];
+    alignas(64) SampleType levels[chunkSize];
+
+    // envelope settings, in seconds, and the steps per sample they come to
+    double sampleRate = 44100.0;
+    float attackTime = 0.005f, decayTime = 0.1f, sustainLevel = 0.7f, releaseTime = 0.2f;
+    SampleType attackStep = 1, decayStep = 1, sustain = (SampleType) 0.7;
+
+    // filter settings, applied to the voices when they are prepared
+    float dcConst = 0.99f;
+    int smoothLength = 4, maxSmoothLength = SmoothingFilter<SampleType>::defaultMaxLength;
+
+    // seed the generators were last started from
+    uint64_t seed = WhiteNoise::makeRandomSeed();
+
+    // per sample step of a stage lasting seconds, a stage always takes at least one sample
+    SampleType getStep(float seconds) const {
+        return (SampleType) (1.0 / std::max(1.0, (double) seconds * sampleRate));
+    }
+    void updateSteps() {
+        sustain = (SampleType) sustainLevel;
+        attackStep = getStep(attackTime);
+        decayStep = (1 - sustain) * getStep(decayTime);
+    }
+
+    // moves level towards target by step a sample, writing gain times each sample's level into env,
+    // until it gets there or runs out of samples; returns the samples written
+    static int ramp(SampleType& level, SampleType target, SampleType step, SampleType gain, SampleType* env, int n) {
+        const SampleType distance = std::abs(target - level);
+        // a zero step only happens when the stage has nowhere to go
+        const int remaining = step > 0 ? (int) std::min((SampleType) n + 1, std::ceil(distance / step)) : 0;
+        const int count = std::min(n, remaining);
+        const SampleType start = level, delta = target > level ? step : -step;
+        for (int s = 0; s < count; s++)
+            env[s] = (start + delta * (SampleType) (s + 1)) * gain;
+        if (count == remaining) {
+            // lands exactly on the target rather than a rounding error either side of it
+            level = target;
+            if (count > 0)
+                env[count - 1] = target * gain;
+        }
+        else {
+            level = start + delta * (SampleType) count;
+        }
+        return count;
+    }
+
+    // writes voice's envelope for the next n samples into env and moves it on
+    void renderEnvelope(Voice& voice, SampleType* env, int n) const {
+        int s = 0;
+        while (s < n) {
+            switch (voice.stage) {
+                case Stage::Attack:
+                    s += ramp(voice.level, 1, attackStep, voice.gain, env + s, n - s);
+                    if (voice.level >= 1)
+                        voice.stage = Stage::Decay;
+                    break;
+                case Stage::Decay:
+                    s += ramp(voice.level, sustain, decayStep, voice.gain, env + s, n - s);
+                    // with no sustain there is nothing left to hear, the voice is free for the next note
+                    if (voice.level == sustain)
+                        voice.stage = sustain > 0 ? Stage::Sustain : Stage::Idle;
+                    break;
+                case Stage::Sustain:
+                    // follows the sustain level, which only jumps if it is moved mid note
+                    voice.level = sustain;
+                    std::fill(env + s, env + n, sustain * voice.gain);
+                    s = n;
+                    break;
+                case Stage::Release:
+                    s += ramp(voice.level, 0, voice.releaseStep, voice.gain, env + s, n - s);
+                    if (voice.level <= 0)
+                        voice.stage = Stage::Idle;
+                    break;
+                case Stage::Idle:
+                    std::fill(env + s, env + n, (SampleType) 0);
+                    s = n;
+                    break;
+            }
+        }
+    }
+
+    // generates the next n samples of group g's voices into their scratch
+    void generateGroup(NoiseType type, int g, SampleType* const* lanes, int n) {
+        if (type == NoiseType::White) {
+            // white voices are generated on their own, so only the ones sounding cost anything
+            for (uint32_t mask = activeLanes[g]; mask != 0; mask &= mask - 1) {
+                const int lane = countTrailingZeros(mask);
+                Voice& voice = voices[g * lanesPerGroup + lane];
+                DistributedWhiteNoise::generate(distribution, whiteVoices[(size_t) (g * lanesPerGroup + lane)],
+                                                voice.whitePosition, lanes[lane], n);
+                voice.whitePosition += (uint64_t) n;
+            }
+        }
+        else if (type == NoiseType::Brown) {
+            brownGroups[(size_t) g].generate(lanes, lanesPerGroup, n);
+        }
+        else {
+            pinkGroups[(size_t) g].generate(lanes, lanesPerGroup, n);
+        }
+    }
+
+    // lets a sounding voice go, it falls from where it is to 0 in the release time
+    void releaseVoice(Voice& voice) {
+        if (voice.stage == Stage::Release || voice.stage == Stage::Idle)
+            return;
+        voice.stage = Stage::Release;
+        voice.releaseStep = voice.level * getStep(releaseTime);
+    }
+
+    // the voice a new note takes: the lowest idle one, or else the oldest, releasing ones first
+    int findVoice() const {
+        for (int g = 0; g < numGroups; g++)
+            if (activeLanes[g] != (1u << lanesPerGroup) - 1)
+                return g * lanesPerGroup + countTrailingZeros(~activeLanes[g]);
+
+        int oldest = 0;
+        for (int v = 1; v < maxVoices; v++) {
+            const bool releasing = voices[v].stage == Stage::Release;
+            const bool oldestReleasing = voices[oldest].stage == Stage::Release;
+            if (releasing != oldestReleasing ? releasing : voices[v].age < voices[oldest].age)
+                oldest = v;
+        }
+        return oldest;
+    }
+
+public:
+    NoiseSynth() = default;
+    NoiseSynth(const NoiseSynth&) = delete;
+    NoiseSynth& operator=(const NoiseSynth&) = delete;
+
+    // allocates every voice's generator, filters and scratch, and restarts from the current seed
+    // allocates so call it from prepareToPlay
+    void prepare() {
+        whiteVoices.resize((size_t) maxVoices);
+        pinkGroups.resize((size_t) numGroups);
+        brownGroups.resize((size_t) numGroups);
+        filters.prepare(maxVoices);
+        filters.setMaxSmoothLength(maxSmoothLength);
+        filters.setSmoothLength(smoothLength);
+        filters.setDCfiltConst(dcConst);
+        scratch.assign((size_t) maxVoices * chunkSize, 0);
+
+        for (auto& white : whiteVoices)
+            white.setMode(WhiteNoise::Mode::Counter);
+        DistributedWhiteNoise::prepare();
+        for (auto& group : pinkGroups)
+            group.setMode(WhiteNoise::Mode::Counter);
+        for (auto& group : brownGroups)
+            group.setMode(WhiteNoise::Mode::Counter);
+        setSeed(seed);
+    }
+
+    // frees everything prepare() allocated, render() does nothing until it is called again
+    void release() {
+        reset();
+        whiteVoices = {};
+        pinkGroups = {};
+        brownGroups = {};
+        filters.release();
+        scratch = {};
+    }
+
+    bool isPrepared() const { return ! scratch.empty(); }
+
+    // reseeds every voice's generator from one seed and silences every voice
+    void setSeed(uint64_t newSeed) {
+        seed = newSeed;
+        uint64_t x = seed;
+        auto next = [&x]() { return WhiteNoise::splitMix(x); };
+        for (auto& white : whiteVoices)
+            white.setSeed(next());
+        for (auto& group : pinkGroups)
+            group.setSeed(next());
+        for (auto& group : brownGroups)
+            group.setSeed(next());
+        for (auto& voice : voices)
+            voice = Voice();
+        for (auto& lanes : activeLanes)
+            lanes = 0;
+        numNotes = 0;
+        filters.reset();
+    }
+    uint64_t getSeed() const { return seed; }
+
+    // silences every voice at once and starts every generator over, so what is played next
+    // sounds the same every time
+    void reset() {
+        if (isPrepared())
+            setSeed(seed);
+    }
+
+    // starts a note on the next free voice, velocity from 0 to 1
+    void noteOn(int channel, int note, float velocity) {
+        if (! isPrepared())
+            return;
+        const int v = findVoice();
+        Voice& voice = voices[v];
+        // a voice that is taken over keeps its level and its filters, so it carries on without a click
+        if (voice.stage == Stage::Idle) {
+            voice.level = 0;
+            filters.resetChannel(v);
+        }
+        voice.stage = Stage::Attack;
+        voice.gain = (SampleType) std::max(0.0f, std::min(1.0f, velocity));
+        voice.note = note;
+        voice.channel = channel;
+        voice.age = numNotes++;
+        activeLanes[v / lanesPerGroup] |= 1u << (v % lanesPerGroup);
+    }
+
+    // releases every voice playing note on channel
+    void noteOff(int channel, int note) {
+        for (int g = 0; g < numGroups; g++)
+            for (uint32_t mask = activeLanes[g]; mask != 0; mask &= mask - 1) {
+                Voice& voice = voices[g * lanesPerGroup + countTrailingZeros(mask)];
+                if (voice.note == note && voice.channel == channel)
+                    releaseVoice(voice);
+            }
+    }
+
+    // releases every voice
+    void allNotesOff() {
+        for (int g = 0; g < numGroups; g++)
+            for (uint32_t mask = activeLanes[g]; mask != 0; mask &= mask - 1)
+                releaseVoice(voices[g * lanesPerGroup + countTrailingZeros(mask)]);
+    }
+
+    int getNumActiveVoices() const {
+        int count = 0;
+        for (auto lanes : activeLanes)
+            for (uint32_t mask = lanes; mask != 0; mask &= mask - 1)
+                count++;
+        return count;
+    }
+
+    // the envelope, times in seconds and the sustain level from 0 to 1
+    // takes effect on every voice from the next sample, notes already released keep their release
+    void setEnvelope(float attack, float decay, float sustainGain, float release) {
+        attackTime = std::max(0.0f, attack);
+        decayTime = std::max(0.0f, decay);
+        sustainLevel = std::max(0.0f, std::min(1.0f, sustainGain));
+        releaseTime = std::max(0.0f, release);
+        updateSteps();
+    }
+    float getAttack() const { return attackTime; }
+    float getDecay() const { return decayTime; }
+    float getSustain() const { return sustainLevel; }
+    float getRelease() const { return releaseTime; }
+
+    void setSampleRate(double newSampleRate) {
+        if (newSampleRate > 0.0)
+            sampleRate = newSampleRate;
+        updateSteps();
+    }
+
+    // the white voices' amplitude distribution, see WhiteDistribution.h
+    void setDistribution(WhiteDistribution newDistribution) { distribution = newDistribution; }
+
+    // filter settings, applied to every voice as NoiseFilter's are, ramped over rampLength
+    // samples as MultiChannelNoise's are
+    void setDCfiltConst(float sliderVal, int rampLength = 0) {
+        dcConst = sliderVal;
+        filters.setDCfiltConst(sliderVal, rampLength);
+    }
+    void setSmoothLength(int sliderVal, int rampLength = 0) {
+        smoothLength = sliderVal;
+        if (rampLength > 0)
+            filters.glideSmoothLength(sliderVal, rampLength);
+        else
+            filters.setSmoothLength(sliderVal);
+    }
+    // longest smoothing length, allocates so call it from prepareToPlay
+    void setMaxSmoothLength(int maxLength) {
+        maxSmoothLength = maxLength;
+        filters.setMaxSmoothLength(maxLength);
+    }
+
+    // plays every sounding voice for n samples and mixes them into buf in place,
+    // buf = buf * (1 - level) + voices * level, the same mix as MultiChannelNoise::render
+    void render(NoiseType type, SampleType* const* buf, int numChannels, int n, bool smooth, bool dcBlock, SampleType level) {
+        ParameterRamp fixed { ParameterRamp::Shape::Linear, (double) level };
+        render(type, buf, numChannels, n, smooth, dcBlock, fixed);
+    }
+    // render() with the level following a ramp, which is moved on n samples
+    void render(NoiseType type, SampleType* const* buf, int numChannels, int n, bool smooth, bool dcBlock, ParameterRamp& level) {
+        if (! isPrepared()) {
+            level.skip(n);
+            return;
+        }
+        NOISE_TRACE_SCOPE("synth");
+        SampleType* lanes[lanesPerGroup];
+
+        for (int start = 0; start < n; start += chunkSize) {
+            const int count = std::min(chunkSize, n - start);
+            std::fill(mix, mix + count, (SampleType) 0);
+
+            for (int g = 0; g < numGroups; g++) {
+                if (activeLanes[g] == 0)
+                    continue;
+                for (int lane = 0; lane < lanesPerGroup; lane++)
+                    lanes[lane] = scratch.data() + (size_t) (g * lanesPerGroup + lane) * chunkSize;
+
+                generateGroup(type, g, lanes, count);
+                filters.processGroups(lanes, g * lanesPerGroup, lanesPerGroup, count, smooth, dcBlock);
+
+                for (uint32_t mask = activeLanes[g]; mask != 0; mask &= mask - 1) {
+                    const int lane = countTrailingZeros(mask);
+                    Voice& voice = voices[g * lanesPerGroup + lane];
+                    renderEnvelope(voice, envelope, count);
+                    const SampleType* NOISE_RESTRICT noise = lanes[lane];
+                    for (int s = 0; s < count; s++)
+                        mix[s] += noise[s] * envelope[s];
+                    if (voice.stage == Stage::Idle)
+                        activeLanes[g] &= ~(1u << lane);
+                }
+            }
+            filters.advance(count, smooth, dcBlock);
+
+            if (level.isRamping()) {
+                level.fill(levels, count);
+                for (int ch = 0; ch < numChannels; ch++) {
+                    SampleType* NOISE_RESTRICT out = buf[ch] + start;
+                    for (int s = 0; s < count; s++)
+                        out[s] += levels[s] * (mix[s] - out[s]);
+                }
+                continue;
+            }
+            const SampleType gain = (SampleType) level.getValue(), dryGain = 1 - gain;
+            for (int ch = 0; ch < numChannels; ch++) {
+                SampleType* NOISE_RESTRICT out = buf[ch] + start;
+                for (int s = 0; s < count; s++)
+                    out[s] = out[s] * dryGain + mix[s] * gain;
+            }
+        }
+    }
+};
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    NoiseTelemetry.h
+    Created: 18 Oct 2026 9:48:31pm
+    Author:  John McRae
+
+    Audio thread performance statistics, for seeing how much of the block
+    deadline the plugin uses.
+
+    processBlock times each block with a ScopedBlock, and the time is
+    recorded against the block's budget (numSamples / sampleRate). The
+    statistics kept are:
+        - blocks and samples processed
+        - the mean and worst cost per sample, and the worst block load
+        - a histogram of the cost per sample in power-of-two ns buckets
+        - overruns, blocks that took longer than their budget
+        - resyncs, play head jumps that made seek() settle the filters,
+          and the samples that settling cost
+
+    The audio thread is the only writer, so every counter is a relaxed
+    atomic that is loaded and stored rather than incremented with a locked
+    instruction, and nothing locks or allocates. The message thread reads
+    a snapshot with getSnapshot(), which can tear between counters by a
+    block but never within one.
+
+    Define NOISE_TELEMETRY=0 to compile all of this out; NoiseTelemetry
+    keeps its interface and does nothing, and enabled is false.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+
+#ifndef NOISE_TELEMETRY
+ #define NOISE_TELEMETRY 1
+#endif
+
+class NoiseTelemetry {
+public:
+    static constexpr bool enabled = NOISE_TELEMETRY != 0;
+    // histogram bucket b counts blocks that cost [2^(b-1), 2^b) ns per sample, bucket 0 is under 1 ns
+    static constexpr int numBuckets = 16;
+
+    // a consistent enough copy of the statistics for the message thread
+    struct Snapshot {
+        uint64_t blocks = 0, samples = 0;
+        uint64_t overruns = 0;
+        uint64_t resyncs = 0, resyncSamples = 0;
+        // mean and worst ns per sample of one channel, see ScopedBlock
+        double meanNsPerSample = 0, worstNsPerSample = 0;
+        // time taken over budget, for the last block and the worst one
+        double lastLoad = 0, worstLoad = 0;
+        uint64_t histogram[numBuckets] = {};
+    };
+
+#if NOISE_TELEMETRY
+private:
+    using Clock = std::chrono::steady_clock;
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+                  "the counters are written from the audio thread, so they must never take a lock");
+
+    // adds to a counter only the audio thread writes, without a locked instruction
+    static void add(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // budget of one sample in ns, set by prepare()
+    std::atomic<double> nsPerSampleBudget { 1e9 / 44100.0 };
+
+    std::atomic<uint64_t> blocks { 0 }, samples { 0 }, channelSamples { 0 }, totalNs { 0 };
+    std::atomic<uint64_t> overruns { 0 };
+    std::atomic<uint64_t> resyncs { 0 }, resyncSamples { 0 };
+    // worst block, as ns per sample and as a fraction of its budget
+    std::atomic<double> worstNsPerSample { 0 }, worstLoad { 0 }, lastLoad { 0 };
+    std::atomic<uint64_t> histogram[numBuckets] = {};
+    // set by the message thread, the audio thread clears the statistics at its next block
+    std::atomic<bool> resetRequested { false };
+
+    void clear() {
+        for (auto* counter : { &blocks, &samples, &channelSamples, &totalNs, &overruns, &resyncs, &resyncSamples })
+            counter->store(0, std::memory_order_relaxed);
+        for (auto& bucket : histogram)
+            bucket.store(0, std::memory_order_relaxed);
+        worstNsPerSample.store(0, std::memory_order_relaxed);
+        worstLoad.store(0, std::memory_order_relaxed);
+        lastLoad.store(0, std::memory_order_relaxed);
+    }
+
+    static int getBucket(uint64_t nsPerSample) {
+        int bucket = 0;
+        while (nsPerSample > 0 && bucket < numBuckets - 1) {
+            nsPerSample >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // records a block of numSamples samples per channel that took ns to process
+    void endBlock(int64_t ns, int numSamples, int numChannels) {
+        // checked with a plain load, so there is no locked instruction unless a reset is pending
+        if (resetRequested.load(std::memory_order_relaxed)) {
+            resetRequested.store(false, std::memory_order_relaxed);
+            clear();
+        }
+        if (numSamples <= 0)
+            return;
+
+        // the load is against the block's own budget, the cost is per sample of one channel
+        const uint64_t numChannelSamples = (uint64_t) numSamples * (uint64_t) (numChannels > 0 ? numChannels : 1);
+        const double load = (double) ns / (nsPerSampleBudget.load(std::memory_order_relaxed) * numSamples);
+        const double nsPerSample = (double) ns / (double) numChannelSamples;
+
+        add(blocks, 1);
+        add(samples, (uint64_t) numSamples);
+        add(channelSamples, numChannelSamples);
+        add(totalNs, (uint64_t) ns);
+        add(histogram[getBucket((uint64_t) nsPerSample)], 1);
+        if (load > 1.0)
+            add(overruns, 1);
+        lastLoad.store(load, std::memory_order_relaxed);
+        if (load > worstLoad.load(std::memory_order_relaxed))
+            worstLoad.store(load, std::memory_order_relaxed);
+        if (nsPerSample > worstNsPerSample.load(std::memory_order_relaxed))
+            worstNsPerSample.store(nsPerSample, std::memory_order_relaxed);
+    }
+
+public:
+    // times one processBlock call from construction to destruction
+    class ScopedBlock {
+    public:
+        ScopedBlock(NoiseTelemetry& t, int numSamples, int numChannels)
+            : telemetry(t), samples(numSamples), channels(numChannels), start(Clock::now()) {}
+        ~ScopedBlock() {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            telemetry.endBlock((int64_t) ns, samples, channels);
+        }
+        ScopedBlock(const ScopedBlock&) = delete;
+        ScopedBlock& operator=(const ScopedBlock&) = delete;
+
+    private:
+        NoiseTelemetry& telemetry;
+        const int samples, channels;
+        const Clock::time_point start;
+    };
+
+    // sets the sample rate the block budgets are worked out from
+    void prepare(double sampleRate) {
+        nsPerSampleBudget.store(1e9 / (sampleRate > 0 ? sampleRate : 44100.0));
+        reset();
+    }
+
+    // counts a play head jump that cost settleSamples samples of filter settling
+    void addResync(uint64_t settleSamples) {
+        add(resyncs, 1);
+        add(resyncSamples, settleSamples);
+    }
+
+    // clears the statistics, from any thread, the audio thread does it at the start of its next block
+    void reset() { resetRequested.store(true); }
+
+    Snapshot getSnapshot() const {
+        Snapshot s;
+        s.blocks = blocks.load(std::memory_order_relaxed);
+        s.samples = samples.load(std::memory_order_relaxed);
+        s.overruns = overruns.load(std::memory_order_relaxed);
+        s.resyncs = resyncs.load(std::memory_order_relaxed);
+        s.resyncSamples = resyncSamples.load(std::memory_order_relaxed);
+        s.worstNsPerSample = worstNsPerSample.load(std::memory_order_relaxed);
+        s.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        s.worstLoad = worstLoad.load(std::memory_order_relaxed);
+        for (int b = 0; b < numBuckets; b++)
+            s.histogram[b] = histogram[b].load(std::memory_order_relaxed);
+        const uint64_t n = channelSamples.load(std::memory_order_relaxed);
+        s.meanNsPerSample = n > 0 ? (double) totalNs.load(std::memory_order_relaxed) / (double) n : 0.0;
+        return s;
+    }
+
+#else
+public:
+    class ScopedBlock {
+    public:
+        ScopedBlock(NoiseTelemetry&, int, int) {}
+    };
+
+    void prepare(double) {}
+    void addResync(uint64_t) {}
+    void reset() {}
+    Snapshot getSnapshot() const { return {}; }
+#endif
+};
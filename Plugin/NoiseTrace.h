@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    NoiseTrace.h
+    Created: 18 Oct 2026 10:57:40pm
+    Author:  John McRae
+
+    Scoped trace markers for seeing where the time goes inside a block,
+    exported as Chrome trace event JSON (chrome://tracing, Perfetto).
+
+    NOISE_TRACE_SCOPE("name") records the time from where it is declared
+    to the end of its scope as one complete event. Each thread writes its
+    events to a ring of its own, all of which are static storage, so
+    tracing never allocates or locks; a thread is given its ring the
+    first time it records an event, looked up by thread id rather than
+    through a thread_local, which can allocate in a plugin. Once a ring is
+    full the oldest events are overwritten.
+
+    Any thread can flush the rings with getChromeJson() or
+    writeChromeJson() while the others keep recording; events overwritten
+    while they are being copied are dropped rather than written torn.
+
+    Everything compiles to nothing unless NOISE_TRACE=1 is defined.
+    The name passed to NOISE_TRACE_SCOPE has to be a string literal.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef NOISE_TRACE
+ #define NOISE_TRACE 0
+#endif
+
+#if NOISE_TRACE
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+
+// one complete event, a scope's name and its start and end in ns
+struct NoiseTraceEvent {
+    const char* name;
+    uint64_t start, end;
+};
+
+// the events of one thread, written only by that thread
+struct alignas(64) NoiseTraceRing {
+    // events kept per thread, a power of two
+    static constexpr int size = 16384;
+
+    std::atomic<std::thread::id> owner {};
+    std::atomic<const char*> threadName { nullptr };
+    // events recorded so far, the next one goes at written % size
+    std::atomic<uint64_t> written { 0 };
+    NoiseTraceEvent events[size];
+};
+
+class NoiseTrace {
+public:
+    // threads that can record, later threads' events are dropped
+    static constexpr int maxThreads = 16;
+    static constexpr int eventsPerThread = NoiseTraceRing::size;
+
+    // records one complete event from construction to destruction
+    class Scope {
+    public:
+        explicit Scope(const char* eventName) : name(eventName), start(now()) {}
+        ~Scope() { record(name, start, now()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        uint64_t start;
+    };
+
+    // names the calling thread in the trace, the name has to outlive the trace
+    static void setThreadName(const char* name) {
+        if (Ring* ring = getRing())
+            ring->threadName.store(name, std::memory_order_relaxed);
+    }
+
+    // clears every ring, only call it while nothing is recording
+    static void clear() {
+        for (auto& ring : rings)
+            ring.written.store(0, std::memory_order_relaxed);
+    }
+
+    // the events in every ring as a Chrome trace event JSON document, allocates
+    static std::string getChromeJson() {
+        std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        char line[256];
+        auto append = [&json, &first, &line] (int length) {
+            if (length <= 0)
+                return;
+            if (! first)
+                json += ",\n";
+            json.append(line, (size_t) std::min(length, (int) sizeof(line) - 1));
+            first = false;
+        };
+
+        for (int t = 0; t < maxThreads; t++) {
+            Ring& ring = rings[t];
+            if (ring.owner.load(std::memory_order_acquire) == std::thread::id())
+                continue;
+
+            if (const char* threadName = ring.threadName.load(std::memory_order_relaxed))
+                append(std::snprintf(line, sizeof(line),
+                                     "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                                     t, threadName));
+
+            // copy the newest events, then drop any the writer may have overwritten meanwhile
+            const uint64_t end = ring.written.load(std::memory_order_acquire);
+            const uint64_t begin = end > (uint64_t) eventsPerThread ? end - eventsPerThread : 0;
+            for (uint64_t i = begin; i < end; i++) {
+                const Event e = ring.events[i & (eventsPerThread - 1)];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // once written reaches i + eventsPerThread the slot is being, or has been, reused
+                if (ring.written.load(std::memory_order_relaxed) - i >= (uint64_t) eventsPerThread)
+                    continue;
+                append(std::snprintf(line, sizeof(line),
+                                     "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                     e.name, t, (double) e.start / 1000.0, (double) (e.end - e.start) / 1000.0));
+            }
+        }
+
+        json += "]}\n";
+        return json;
+    }
+
+    // writes getChromeJson() to path, returns false if the file could not be written
+    static bool writeChromeJson(const char* path) {
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr)
+            return false;
+        const std::string json = getChromeJson();
+        const bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+private:
+    using Ring = NoiseTraceRing;
+    using Event = NoiseTraceEvent;
+
+    static inline Ring rings[maxThreads];
+
+    static uint64_t now() {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // the calling thread's ring, claimed the first time it is asked for, nullptr once they have all gone
+    static Ring* getRing() {
+        const std::thread::id self = std::this_thread::get_id();
+        const size_t start = std::hash<std::thread::id>()(self) % maxThreads;
+        for (int probe = 0; probe < maxThreads; probe++) {
+            Ring& ring = rings[(start + (size_t) probe) % maxThreads];
+            std::thread::id owner = ring.owner.load(std::memory_order_acquire);
+            if (owner == self)
+                return &ring;
+            if (owner == std::thread::id()
+                && ring.owner.compare_exchange_strong(owner, self, std::memory_order_acq_rel))
+                return &ring;
+        }
+        return nullptr;
+    }
+
+    static void record(const char* name, uint64_t start, uint64_t end) {
+        Ring* ring = getRing();
+        if (ring == nullptr)
+            return;
+        // only this thread writes to its ring, so a load and store is enough
+        const uint64_t index = ring->written.load(std::memory_order_relaxed);
+        ring->events[index & (eventsPerThread - 1)] = { name, start, end };
+        ring->written.store(index + 1, std::memory_order_release);
+    }
+};
+
+#define NOISE_TRACE_CONCAT_(a, b) a##b
+#define NOISE_TRACE_CONCAT(a, b) NOISE_TRACE_CONCAT_(a, b)
+#define NOISE_TRACE_SCOPE(name) const NoiseTrace::Scope NOISE_TRACE_CONCAT(noiseTraceScope_, __LINE__) (name)
+#define NOISE_TRACE_THREAD(name) NoiseTrace::setThreadName(name)
+
+#else
+#define NOISE_TRACE_SCOPE(name)
+#define NOISE_TRACE_THREAD(name)
+#endif
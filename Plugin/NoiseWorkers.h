@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    NoiseWorkers.h
+    Created: 19 Oct 2026 4:02:18pm
+    Author:  John McRae
+
+    A small pool of worker threads for splitting a wide bus between cores
+    while the host renders offline. Standard library only, like the rest
+    of the DSP headers.
+
+    run() hands out jobs 0 to numJobs - 1 from an atomic counter to the
+    workers and the calling thread, and returns once every job is done,
+    so the caller never waits on work it could be doing itself. It locks
+    and wakes threads, which is fine for an offline bounce but not for the
+    audio thread, so MultiChannelNoise only uses a pool it has been given
+    (see MultiChannelNoise::setWorkers) and the processor only gives it
+    one while isNonRealtime().
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class NoiseWorkers {
+public:
+    NoiseWorkers() = default;
+    ~NoiseWorkers() { stop(); }
+    NoiseWorkers(const NoiseWorkers&) = delete;
+    NoiseWorkers& operator=(const NoiseWorkers&) = delete;
+
+    // starts numThreads - 1 workers to go with the calling thread, 0 for one per core
+    // does nothing if that many are already running
+    void start(int numThreads = 0) {
+        if (numThreads <= 0)
+            numThreads = (int) std::max(1u, std::thread::hardware_concurrency());
+        if (numThreads - 1 == (int) threads.size())
+            return;
+
+        stop();
+        quit = false;
+        // the workers start from the current batch, so they only take part in later ones
+        for (int i = 1; i < numThreads; i++)
+            threads.emplace_back([this, current = batch] { workerLoop(current); });
+    }
+
+    void stop() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+    }
+
+    // threads run() spreads jobs over, the caller included
+    int getNumThreads() const { return (int) threads.size() + 1; }
+
+    // calls job(i) for every i in [0, numJobs) across the pool, returns when they have all finished
+    template <typename Job>
+    void run(int numJobs, Job& job) {
+        runJobs(numJobs, [] (void* context, int index) { (*static_cast<Job*>(context))(index); }, &job);
+    }
+
+private:
+    using JobFunction = void (*)(void*, int);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    bool quit = false;
+
+    // the batch being run, bumped for every run() so a worker takes part in each batch once
+    uint64_t batch = 0;
+    JobFunction function = nullptr;
+    void* context = nullptr;
+    int numJobs = 0;
+    std::atomic<int> nextJob { 0 };
+    // workers still inside the current batch
+    int busy = 0;
+
+    // takes jobs until there are none left
+    void takeJobs(JobFunction fn, void* ctx, int count) {
+        for (int index = nextJob.fetch_add(1); index < count; index = nextJob.fetch_add(1))
+            fn(ctx, index);
+    }
+
+    void runJobs(int count, JobFunction fn, void* ctx) {
+        if (threads.empty() || count <= 1) {
+            for (int index = 0; index < count; index++)
+                fn(ctx, index);
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            function = fn;
+            context = ctx;
+            numJobs = count;
+            nextJob.store(0);
+            busy = (int) threads.size();
+            ++batch;
+        }
+        wake.notify_all();
+
+        takeJobs(fn, ctx, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return busy == 0; });
+    }
+
+    void workerLoop(uint64_t seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this, seen] { return quit || batch != seen; });
+            if (quit)
+                return;
+            seen = batch;
+            const JobFunction fn = function;
+            void* const ctx = context;
+            const int count = numJobs;
+
+            lock.unlock();
+            takeJobs(fn, ctx, count);
+            lock.lock();
+
+            if (--busy == 0)
+                finished.notify_one();
+        }
+    }
+};
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+    Created: 19 Oct 2026 8:05:37pm
+    Author:  John McRae
+
+    A parameter that moves to each new value over a number of samples
+    instead of jumping, so automation and slider moves don't click.
+
+    The processor reads its parameters once per block, so a ramp is
+    started at the top of each block towards the value the host has
+    set, lasting the block (or a few milliseconds, for very short
+    blocks). Hosts that split their blocks at automation points then get
+    a ramp from each point to the next, so the more finely the host
+    resolves automation the more closely the output follows it, and the
+    audio thread still only reads each parameter once per block.
+
+    Linear ramps move by the same amount every sample. Exponential ramps
+    move by the same ratio, which sounds even for gains; a ramp to or
+    from zero can't be exponential and is linear instead.
+
+    fill() writes the ramp out a block at a time for the kernels to read,
+    so applying it is one multiply per sample like a fixed gain. Linear
+    ramps are written independently for every sample and exponential
+    ones eight samples apart, both of which vectorise.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+class ParameterRamp {
+public:
+    enum class Shape { Linear, Exponential };
+
+private:
+    Shape shape;
+    // the value reached so far, where the ramp is heading and the samples it has left
+    double value = 0, target = 0;
+    int remaining = 0;
+    // added to the value every sample, or for an exponential ramp what it is multiplied by
+    double step = 0;
+    bool exponential = false;
+
+public:
+    explicit ParameterRamp(Shape rampShape = Shape::Linear, double initialValue = 0)
+        : shape(rampShape), value(initialValue), target(initialValue) {}
+
+    // jumps straight to newValue, ending any ramp
+    void setValue(double newValue) {
+        value = target = newValue;
+        remaining = 0;
+    }
+
+    // starts a ramp from wherever the value is now to newTarget over length samples,
+    // a length of 0 or less jumps; does nothing when it is already heading there
+    void setTarget(double newTarget, int length) {
+        if (newTarget == target)
+            return;
+        target = newTarget;
+        if (length <= 0 || value == target) {
+            setValue(newTarget);
+            return;
+        }
+        remaining = length;
+        exponential = shape == Shape::Exponential && value > 0 && target > 0;
+        step = exponential ? std::pow(target / value, 1.0 / length) : (target - value) / length;
+    }
+
+    double getValue() const { return value; }
+    double getTarget() const { return target; }
+    bool isRamping() const { return remaining > 0; }
+    // samples until the ramp reaches its target
+    int getRemaining() const { return remaining; }
+
+    // the value k samples on, k >= 0, without moving the ramp
+    double getValueAfter(int k) const {
+        if (k >= remaining)
+            return target;
+        return exponential ? value * std::pow(step, (double) k) : value + step * k;
+    }
+
+    // moves the ramp on n samples without writing it out
+    void skip(int n) {
+        if (n <= 0 || remaining <= 0)
+            return;
+        if (n >= remaining) {
+            setValue(target);
+            return;
+        }
+        value = getValueAfter(n);
+        remaining -= n;
+    }
+
+    // writes the value at each of the next n samples into dst and moves the ramp on,
+    // the first sample written being one step on from getValue()
+    template <typename SampleType>
+    void fill(SampleType* dst, int n) {
+        if (n <= 0)
+            return;
+        const int count = std::min(n, remaining);
+        if (exponential) {
+            // eight samples serially, then each from the one eight before it
+            const int first = std::min(count, 8);
+            double v = value;
+            for (int s = 0; s < first; s++) {
+                v *= step;
+                dst[s] = (SampleType) v;
+            }
+            const SampleType ratio8 = (SampleType) std::pow(step, 8.0);
+            for (int s = first; s < count; s++)
+                dst[s] = dst[s - 8] * ratio8;
+        }
+        else {
+            const double start = value, delta = step;
+            for (int s = 0; s < count; s++)
+                dst[s] = (SampleType) (start + delta * (s + 1));
+        }
+        // the ramp lands exactly on its target, and stays there
+        if (count == remaining && count > 0)
+            dst[count - 1] = (SampleType) target;
+        std::fill(dst + count, dst + n, (SampleType) target);
+        skip(count);
+    }
+};
@@ -11,7 +11,8 @@
 
 //==============================================================================
 NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEditor(NoiseGeneratorPluginAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p)
+    : AudioProcessorEditor(&p), audioProcessor(p), statsPanel(p.telemetry),
+      analyserView(p.analyserFifo, p)
 {
     // Apple II font from http://www.kreativekorp.com/software/fonts/apple2.shtml
     // this line is important to ensure that the custom font is used
@@ -36,6 +37,9 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     wAttach   = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, WHITE_ID, wButton);
     pAttach   = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, PINK_ID,  pButton);
     bAttach   = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, BROWN_ID, bButton);
+    cAttach   = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, COLOUR_ID, cButton);
+    ditherAttach = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, DITHER_ID, ditherButton);
+    greyAttach = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, GREY_ID, greyButton);
     onAttach  = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, STATE_ID, onButton);
     dcAttach  = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, DC_ID,    dcButton);
     avgAttach = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, AVG_ID,   avgButton);
@@ -46,6 +50,9 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     wButton.setButtonText("White");
     pButton.setButtonText("Pink");
     bButton.setButtonText("Brown");
+    cButton.setButtonText("1/f^a");
+    ditherButton.setButtonText("Dither");
+    greyButton.setButtonText("grey");
     onButton.setButtonText("ON");
     dcButton.setButtonText("DC");
     avgButton.setButtonText("smooth");
@@ -53,6 +60,9 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     wButton.onClick   = [this] { updateToggleState(&wButton,   "White"); };
     pButton.onClick   = [this] { updateToggleState(&pButton,   "Pink"); };
     bButton.onClick   = [this] { updateToggleState(&bButton,   "Brown"); };
+    cButton.onClick   = [this] { updateToggleState(&cButton,   "Coloured"); };
+    ditherButton.onClick = [this] { updateToggleState(&ditherButton, "Dither"); };
+    greyButton.onClick = [this] { updateToggleState(&greyButton, "Grey"); };
     onButton.onClick  = [this] { updateToggleState(&onButton,  "On"); };
     dcButton.onClick  = [this] { updateToggleState(&dcButton,  "DC block"); };
     avgButton.onClick = [this] { updateToggleState(&avgButton, "Smooth"); };
@@ -61,11 +71,16 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     wButton.setRadioGroupId(NoiseButtons);
     pButton.setRadioGroupId(NoiseButtons);
     bButton.setRadioGroupId(NoiseButtons);
+    cButton.setRadioGroupId(NoiseButtons);
+    ditherButton.setRadioGroupId(NoiseButtons);
 
     // set formatting
     wButton.setLookAndFeel(&oldSchoolLookAndFeel);
     pButton.setLookAndFeel(&oldSchoolLookAndFeel);
     bButton.setLookAndFeel(&oldSchoolLookAndFeel);
+    cButton.setLookAndFeel(&oldSchoolLookAndFeel);
+    ditherButton.setLookAndFeel(&oldSchoolLookAndFeel);
+    greyButton.setLookAndFeel(&oldSchoolLookAndFeel);
     onButton.setLookAndFeel(&oldSchoolLookAndFeel);
     dcButton.setLookAndFeel(&oldSchoolLookAndFeel);
     avgButton.setLookAndFeel(&oldSchoolLookAndFeel);
@@ -73,12 +88,17 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     // Set edges for the noise selection row
     wButton.setConnectedEdges(2);
     pButton.setConnectedEdges(3);
-    bButton.setConnectedEdges(1);
+    bButton.setConnectedEdges(3);
+    cButton.setConnectedEdges(3);
+    ditherButton.setConnectedEdges(1);
 
     // set the noise buttons to not be toggle switches
     wButton.setClickingTogglesState(true);
     pButton.setClickingTogglesState(true);
     bButton.setClickingTogglesState(true);
+    cButton.setClickingTogglesState(true);
+    ditherButton.setClickingTogglesState(true);
+    greyButton.setClickingTogglesState(true);
     onButton.setClickingTogglesState(true);
     dcButton.setClickingTogglesState(true);
     avgButton.setClickingTogglesState(true);
@@ -86,6 +106,9 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     addAndMakeVisible(&wButton);
     addAndMakeVisible(&pButton);
     addAndMakeVisible(&bButton);
+    addAndMakeVisible(&cButton);
+    addAndMakeVisible(&ditherButton);
+    addAndMakeVisible(&greyButton);
     addAndMakeVisible(&onButton);
     addAndMakeVisible(&dcButton);
     addAndMakeVisible(&avgButton);
@@ -102,10 +125,133 @@ NoiseGeneratorPluginAudioProcessorEditor::NoiseGeneratorPluginAudioProcessorEdit
     levelSlider.setColour(Slider::backgroundColourId, Colours::black);
     addAndMakeVisible(&levelSlider);
 
+    // filter sliders, the value pops up while dragging since there is no room for a text box
+    dcSliderAttach  = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, DC_SLIDER_ID,  dcSlider);
+    avgSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, AVG_SLIDER_ID, avgSlider);
+    widthSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, WIDTH_ID, widthSlider);
+    exponentSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, EXPONENT_ID, exponentSlider);
+
+    for (auto* slider : { &dcSlider, &avgSlider, &widthSlider, &exponentSlider })
+    {
+        slider->setSliderStyle(Slider::LinearBar);
+        slider->setTextBoxStyle(Slider::NoTextBox, true, 0, 0);
+        slider->setPopupDisplayEnabled(true, true, this);
+        slider->setLookAndFeel(&oldSchoolLookAndFeel);
+        slider->setColour(Slider::backgroundColourId, Colours::black);
+        addAndMakeVisible(slider);
+    }
+    dcSlider.setTooltip(DC_SLIDER_NAME);
+    avgSlider.setTooltip(AVG_SLIDER_NAME);
+    widthSlider.setTooltip(WIDTH_NAME);
+    exponentSlider.setTooltip(EXPONENT_NAME);
+
+    // BAND FILTER
+    // the items go in before the attachment, which selects the parameter's current choice
+    bandBox.addItemList(StringArray { "full band", "octave", "1/3 oct" }, 1);
+    bandBox.setJustificationType(Justification::centred);
+    bandBox.setLookAndFeel(&oldSchoolLookAndFeel);
+    bandBox.setColour(ComboBox::backgroundColourId, Colours::black);
+    bandBox.setColour(ComboBox::textColourId, Colours::green);
+    bandBox.setColour(ComboBox::outlineColourId, Colours::green);
+    bandBox.setColour(ComboBox::arrowColourId, Colours::green);
+    bandBox.setTooltip(BAND_NAME);
+    bandAttach = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.treeState, BAND_ID, bandBox);
+    addAndMakeVisible(&bandBox);
+
+    bandCentreSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, BAND_CENTRE_ID, bandCentreSlider);
+    bandCentreSlider.setSliderStyle(Slider::LinearBar);
+    bandCentreSlider.setTextBoxStyle(Slider::NoTextBox, true, 0, 0);
+    bandCentreSlider.setPopupDisplayEnabled(true, true, this);
+    bandCentreSlider.setTextValueSuffix(" Hz");
+    bandCentreSlider.setLookAndFeel(&oldSchoolLookAndFeel);
+    bandCentreSlider.setColour(Slider::backgroundColourId, Colours::black);
+    bandCentreSlider.setTooltip(BAND_CENTRE_NAME);
+    addAndMakeVisible(&bandCentreSlider);
+
+    bandSpreadAttach = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, BAND_SPREAD_ID, bandSpreadButton);
+    bandSpreadButton.setButtonText("per ch");
+    bandSpreadButton.setClickingTogglesState(true);
+    bandSpreadButton.setLookAndFeel(&oldSchoolLookAndFeel);
+    bandSpreadButton.setTooltip(BAND_SPREAD_NAME);
+    bandSpreadButton.onClick = [this] { updateToggleState(&bandSpreadButton, "Band per channel"); };
+    addAndMakeVisible(&bandSpreadButton);
+
+    // WHITE NOISE DISTRIBUTION
+    distributionBox.addItemList(StringArray { "uniform 0-1", "uniform", "TPDF", "gaussian" }, 1);
+    distributionBox.setJustificationType(Justification::centred);
+    distributionBox.setLookAndFeel(&oldSchoolLookAndFeel);
+    distributionBox.setColour(ComboBox::backgroundColourId, Colours::black);
+    distributionBox.setColour(ComboBox::textColourId, Colours::green);
+    distributionBox.setColour(ComboBox::outlineColourId, Colours::green);
+    distributionBox.setColour(ComboBox::arrowColourId, Colours::green);
+    distributionBox.setTooltip(DISTRIBUTION_NAME);
+    distributionAttach = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.treeState, DISTRIBUTION_ID, distributionBox);
+    addAndMakeVisible(&distributionBox);
+
+    // MIDI SYNTH
+    // the switch, then the envelope sliders along the row under it
+    synthAttach = std::make_unique<AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.treeState, SYNTH_ID, synthButton);
+    synthButton.setButtonText("MIDI");
+    synthButton.setClickingTogglesState(true);
+    synthButton.setLookAndFeel(&oldSchoolLookAndFeel);
+    synthButton.setTooltip(SYNTH_NAME);
+    synthButton.onClick = [this] { updateToggleState(&synthButton, "MIDI synth"); };
+    addAndMakeVisible(&synthButton);
+
+    attackSliderAttach  = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, ATTACK_ID,  attackSlider);
+    decaySliderAttach   = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, DECAY_ID,   decaySlider);
+    sustainSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, SUSTAIN_ID, sustainSlider);
+    releaseSliderAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, RELEASE_ID, releaseSlider);
+
+    for (auto* slider : { &attackSlider, &decaySlider, &sustainSlider, &releaseSlider })
+    {
+        slider->setSliderStyle(Slider::LinearBar);
+        slider->setTextBoxStyle(Slider::NoTextBox, true, 0, 0);
+        slider->setPopupDisplayEnabled(true, true, this);
+        slider->setLookAndFeel(&oldSchoolLookAndFeel);
+        slider->setColour(Slider::backgroundColourId, Colours::black);
+        addAndMakeVisible(slider);
+    }
+    for (auto* slider : { &attackSlider, &decaySlider, &releaseSlider })
+        slider->setTextValueSuffix(" ms");
+    attackSlider.setTooltip(ATTACK_NAME);
+    decaySlider.setTooltip(DECAY_NAME);
+    sustainSlider.setTooltip(SUSTAIN_NAME);
+    releaseSlider.setTooltip(RELEASE_NAME);
+
+    // DITHER
+    // the dither type, bit depth and noise shaping, used while the dither button is selected
+    ditherTypeBox.addItemList(StringArray { "TPDF", "HP TPDF" }, 1);
+    ditherBitsBox.addItemList(StringArray { "8 bit", "16 bit", "20 bit", "24 bit" }, 1);
+    shapingBox.addItemList(StringArray { "no shaping", "1st order", "2nd order", "E-weighted", "F-weighted" }, 1);
+    for (auto* box : { &ditherTypeBox, &ditherBitsBox, &shapingBox })
+    {
+        box->setJustificationType(Justification::centred);
+        box->setLookAndFeel(&oldSchoolLookAndFeel);
+        box->setColour(ComboBox::backgroundColourId, Colours::black);
+        box->setColour(ComboBox::textColourId, Colours::green);
+        box->setColour(ComboBox::outlineColourId, Colours::green);
+        box->setColour(ComboBox::arrowColourId, Colours::green);
+        addAndMakeVisible(box);
+    }
+    ditherTypeBox.setTooltip(DITHER_TYPE_NAME);
+    ditherBitsBox.setTooltip(DITHER_BITS_NAME);
+    shapingBox.setTooltip(SHAPING_NAME);
+    ditherTypeAttach = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.treeState, DITHER_TYPE_ID, ditherTypeBox);
+    ditherBitsAttach = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.treeState, DITHER_BITS_ID, ditherBitsBox);
+    shapingAttach    = std::make_unique<AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.treeState, SHAPING_ID, shapingBox);
+
+    // STATS
+    if (NoiseTelemetry::enabled)
+        addAndMakeVisible(&statsPanel);
+
+    // ANALYSER
+    addAndMakeVisible(&analyserView);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     // setSize(320, 180); - ORIGINAL
-    setSize(320, 220);
+    setSize(320, NoiseTelemetry::enabled ? 550 : 520);
 }
 
 NoiseGeneratorPluginAudioProcessorEditor::~NoiseGeneratorPluginAudioProcessorEditor()
@@ -123,15 +269,52 @@ void NoiseGeneratorPluginAudioProcessorEditor::resized()
 {
     titleLabel.setBounds(32, 7, 256, 36);
 
-    wButton.setBounds(30,  50, 85, 45);
-    pButton.setBounds(115, 50, 85, 45);
-    bButton.setBounds(200, 50, 85, 45);
+    wButton.setBounds(30,  50, 51, 45);
+    pButton.setBounds(81,  50, 51, 45);
+    bButton.setBounds(132, 50, 51, 45);
+    cButton.setBounds(183, 50, 51, 45);
+    ditherButton.setBounds(234, 50, 51, 45);
     
     onButton.setBounds (30,  105, 85, 30);
     dcButton.setBounds (115, 105, 85, 30);
     avgButton.setBounds(200, 105, 85, 30);
     
     levelSlider.setBounds(30, 150, 255, 35);
+
+    // filter sliders sit under the DC and smooth buttons, width under the on button
+    widthSlider.setBounds(30, 195, 85, 20);
+    dcSlider.setBounds (115, 195, 85, 20);
+    avgSlider.setBounds(200, 195, 85, 20);
+
+    // the coloured noise's exponent and the grey switch
+    exponentSlider.setBounds(30, 225, 170, 20);
+    greyButton.setBounds(200, 225, 85, 20);
+
+    // band filter: octave or third octave, the centre band, and a band per channel
+    bandBox.setBounds(30, 255, 85, 20);
+    bandCentreSlider.setBounds(115, 255, 85, 20);
+    bandSpreadButton.setBounds(200, 255, 85, 20);
+
+    // the white noise's distribution and the MIDI synth switch
+    distributionBox.setBounds(30, 285, 85, 20);
+    synthButton.setBounds(115, 285, 85, 20);
+
+    // the synth's envelope
+    attackSlider.setBounds (30,  315, 64, 20);
+    decaySlider.setBounds  (94,  315, 64, 20);
+    sustainSlider.setBounds(158, 315, 64, 20);
+    releaseSlider.setBounds(222, 315, 63, 20);
+
+    // the dither's type, bit depth and noise shaping
+    ditherTypeBox.setBounds(30, 345, 85, 20);
+    ditherBitsBox.setBounds(115, 345, 85, 20);
+    shapingBox.setBounds(200, 345, 85, 20);
+
+    // stats panel along the bottom, under the sliders
+    statsPanel.setBounds(30, 378, 255, 30);
+
+    // analyser under the stats panel, or in its place when telemetry is compiled out
+    analyserView.setBounds(30, NoiseTelemetry::enabled ? 418 : 378, 255, 120);
 }
 
 void NoiseGeneratorPluginAudioProcessorEditor::updateToggleState(Button* button, String name)
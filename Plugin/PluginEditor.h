@@ -11,6 +11,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "OldSchoolLaF.h"
+#include "StatsPanel.h"
+#include "AnalyserView.h"
 // add this so I don't have to scope the juce stuff everytime
 using namespace juce;
 
@@ -42,18 +44,41 @@ private:
 
     // look and feel class declaration
     OldScoolLaF  oldSchoolLookAndFeel;
+    // pops up the tooltips set on the controls below when the mouse rests on one
+    TooltipWindow tooltipWindow { this };
     // GUI object declarations
     TextButton wButton;
     TextButton pButton;
     TextButton bButton;
+    TextButton cButton;
+    TextButton greyButton;
     TextButton onButton;
     TextButton dcButton;
     TextButton avgButton;
+    TextButton bandSpreadButton;
+    TextButton synthButton;
+    TextButton ditherButton;
     Slider levelSlider;
     Slider dcSlider;
     Slider avgSlider;
+    Slider widthSlider;
+    Slider exponentSlider;
+    Slider bandCentreSlider;
+    Slider attackSlider;
+    Slider decaySlider;
+    Slider sustainSlider;
+    Slider releaseSlider;
+    ComboBox bandBox;
+    ComboBox distributionBox;
+    ComboBox ditherTypeBox;
+    ComboBox ditherBitsBox;
+    ComboBox shapingBox;
     Label titleLabel;
     Label levelLabel;
+    // audio thread statistics, only shown when telemetry is compiled in
+    StatsPanel statsPanel;
+    // output spectrum and scope, along the bottom
+    AnalyserView analyserView;
 
     // set OldSchoolLookAndFeel colours here
     void setupOldSchoolAndFeelColours(LookAndFeel& laf);
@@ -63,12 +88,29 @@ public:
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> wAttach;
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> pAttach;
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> bAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> cAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> greyAttach;
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> onAttach;
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> dcAttach;
     std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> avgAttach;
     std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> levelAttach;
     std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> dcSliderAttach;
     std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> avgSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> widthSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> exponentSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> bandCentreSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> bandSpreadAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ComboBoxAttachment> bandAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ComboBoxAttachment> distributionAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> synthAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> attackSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> decaySliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> sustainSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::SliderAttachment> releaseSliderAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ButtonAttachment> ditherAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ComboBoxAttachment> ditherTypeAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ComboBoxAttachment> ditherBitsAttach;
+    std::unique_ptr <AudioProcessorValueTreeState::ComboBoxAttachment> shapingAttach;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoiseGeneratorPluginAudioProcessorEditor)
 };
@@ -9,6 +9,15 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    // "NGst" as a little endian int, the first four bytes of the binary state
+    // (states from before it are XML, which copyXmlToBinary starts with a different magic number)
+    const int stateMagic = 0x7473474e;
+    // bumped whenever fields are added to the end, older versions are still read
+    const int stateVersion = 1;
+}
+
 //==============================================================================
 // Constructor
 NoiseGeneratorPluginAudioProcessor::NoiseGeneratorPluginAudioProcessor()
@@ -24,10 +33,95 @@ NoiseGeneratorPluginAudioProcessor::NoiseGeneratorPluginAudioProcessor()
     treeState(*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
 {
+    // cache the parameter values so processBlock doesn't have to look them up by ID
+    whiteParam     = treeState.getRawParameterValue(WHITE_ID);
+    pinkParam      = treeState.getRawParameterValue(PINK_ID);
+    brownParam     = treeState.getRawParameterValue(BROWN_ID);
+    stateParam     = treeState.getRawParameterValue(STATE_ID);
+    dcParam        = treeState.getRawParameterValue(DC_ID);
+    avgParam       = treeState.getRawParameterValue(AVG_ID);
+    levelParam     = treeState.getRawParameterValue(LEVEL_ID);
+    dcSliderParam  = treeState.getRawParameterValue(DC_SLIDER_ID);
+    avgSliderParam = treeState.getRawParameterValue(AVG_SLIDER_ID);
+    widthParam     = treeState.getRawParameterValue(WIDTH_ID);
+    colourParam    = treeState.getRawParameterValue(COLOUR_ID);
+    greyParam      = treeState.getRawParameterValue(GREY_ID);
+    exponentParam  = treeState.getRawParameterValue(EXPONENT_ID);
+    bandParam      = treeState.getRawParameterValue(BAND_ID);
+    bandCentreParam = treeState.getRawParameterValue(BAND_CENTRE_ID);
+    bandSpreadParam = treeState.getRawParameterValue(BAND_SPREAD_ID);
+    distributionParam = treeState.getRawParameterValue(DISTRIBUTION_ID);
+    synthParam     = treeState.getRawParameterValue(SYNTH_ID);
+    attackParam    = treeState.getRawParameterValue(ATTACK_ID);
+    decayParam     = treeState.getRawParameterValue(DECAY_ID);
+    sustainParam   = treeState.getRawParameterValue(SUSTAIN_ID);
+    releaseParam   = treeState.getRawParameterValue(RELEASE_ID);
+    ditherParam    = treeState.getRawParameterValue(DITHER_ID);
+    ditherTypeParam = treeState.getRawParameterValue(DITHER_TYPE_ID);
+    ditherBitsParam = treeState.getRawParameterValue(DITHER_BITS_ID);
+    shapingParam   = treeState.getRawParameterValue(SHAPING_ID);
+
+    // the parameters in the order the state saves them, new ones go on the end
+    for (auto* id : { WHITE_ID, PINK_ID, BROWN_ID, STATE_ID, DC_ID, AVG_ID, LEVEL_ID, DC_SLIDER_ID, AVG_SLIDER_ID, WIDTH_ID,
+                      COLOUR_ID, GREY_ID, EXPONENT_ID, BAND_ID, BAND_CENTRE_ID, BAND_SPREAD_ID, DISTRIBUTION_ID,
+                      SYNTH_ID, ATTACK_ID, DECAY_ID, SUSTAIN_ID, RELEASE_ID,
+                      DITHER_ID, DITHER_TYPE_ID, DITHER_BITS_ID, SHAPING_ID })
+        savedParameters.push_back({ id, treeState.getParameter(id) });
+
+    // round each program's values the way the parameters will, so a program's snapshot is
+    // exactly what the parameters hold once it has been applied
+    auto quantise = [this] (const char* id, float value)
+    {
+        auto* param = treeState.getParameter(id);
+        return param->convertFrom0to1(param->convertTo0to1(value));
+    };
+    for (int i = 0; i < numPrograms; ++i)
+    {
+        ParameterSnapshot params = factoryPrograms[i].params;
+        params.level        = quantise(LEVEL_ID,     params.level);
+        params.dcConst      = quantise(DC_SLIDER_ID, params.dcConst);
+        params.width        = quantise(WIDTH_ID,     params.width);
+        params.smoothLength = juce::roundToInt(quantise(AVG_SLIDER_ID, (float) params.smoothLength));
+        params.exponent     = quantise(EXPONENT_ID,  params.exponent);
+        params.bandCentre   = quantise(BAND_CENTRE_ID, params.bandCentre);
+        params.attack       = quantise(ATTACK_ID,    params.attack);
+        params.decay        = quantise(DECAY_ID,     params.decay);
+        params.sustain      = quantise(SUSTAIN_ID,   params.sustain);
+        params.release      = quantise(RELEASE_ID,   params.release);
+        programSnapshots[i] = params;
+    }
+
+    // a jump's settle goes into the stats panel's numbers
+    core.setTelemetry(&telemetry);
+    // program changes are finished, and the coloured noise's shaping filter is worked out while
+    // playing, on the message thread
+    startTimerHz(30);
 }
 
 NoiseGeneratorPluginAudioProcessor::~NoiseGeneratorPluginAudioProcessor()
 {
+    stopTimer();
+}
+
+void NoiseGeneratorPluginAudioProcessor::timerCallback()
+{
+    // a program change is finished once a block has acknowledged it, or once no block is running,
+    // since every block that starts after the program was set picks it up; see setCurrentProgram.
+    // The program is only cleared if it is still the pending one, a newer one waits for the next tick
+    int program = pendingProgram.load();
+    if (program >= 0 && (acknowledgedProgram.load() == program || ! inBlock.load()))
+    {
+        applyParameters(programSnapshots[program]);
+        pendingProgram.compare_exchange_strong(program, -1);
+    }
+
+    // a design FFT and a few thousand pow() calls, too much for the audio thread, so the
+    // prepared engine is handed the new filter and takes it up at its next block; offline
+    // the audio thread works it out itself, see NoiseProcessorCore::updateFilters, so a
+    // bounce follows the slider exactly
+    if (isNonRealtime())
+        return;
+    core.designColour(exponentParam->load(), greyParam->load() >= 0.5f);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout NoiseGeneratorPluginAudioProcessor::createParameterLayout()
@@ -40,13 +134,52 @@ juce::AudioProcessorValueTreeState::ParameterLayout NoiseGeneratorPluginAudioPro
     layout.add(std::make_unique<AudioParameterBool>(WHITE_ID, WHITE_NAME, false));
     layout.add(std::make_unique<AudioParameterBool>(PINK_ID, PINK_NAME, false));
     layout.add(std::make_unique<AudioParameterBool>(BROWN_ID, BROWN_NAME, false));
+    // 1/f^a noise of any exponent, or grey noise, see ColouredNoise.h
+    layout.add(std::make_unique<AudioParameterBool>(COLOUR_ID, COLOUR_NAME, false));
+    layout.add(std::make_unique<AudioParameterBool>(GREY_ID, GREY_NAME, false));
     layout.add(std::make_unique<AudioParameterBool>(STATE_ID, STATE_NAME, true));
     layout.add(std::make_unique<AudioParameterBool>(DC_ID, DC_NAME, true));
     layout.add(std::make_unique<AudioParameterBool>(AVG_ID, AVG_NAME, true));
     // SLIDERS
     layout.add(std::make_unique<AudioParameterFloat>(LEVEL_ID, LEVEL_NAME, 0.0f, 1.0f, 0.0f));
-    layout.add(std::make_unique<AudioParameterFloat>(DC_SLIDER_ID, DC_SLIDER_NAME, 0.0f, 1.0f, 0.0f));
-    layout.add(std::make_unique<AudioParameterFloat>(AVG_SLIDER_ID, AVG_SLIDER_NAME, 1.0f, 2.0f, 1.0f)); // CHECK - min, max, default?
+    // DC filter pole, the defaults match the NoiseFilter defaults
+    layout.add(std::make_unique<AudioParameterFloat>(DC_SLIDER_ID, DC_SLIDER_NAME, 0.9f, 0.999f, 0.99f));
+    // smoothing length in samples
+    layout.add(std::make_unique<AudioParameterInt>(AVG_SLIDER_ID, AVG_SLIDER_NAME, 1, AVG_SLIDER_MAX, 4));
+    // 1 - independent noise on every channel, 0 - the same noise on every channel
+    layout.add(std::make_unique<AudioParameterFloat>(WIDTH_ID, WIDTH_NAME, 0.0f, 1.0f, 1.0f));
+    // the coloured noise's slope is -3 dB per octave per unit: 2 brown, 1 pink, 0 white, -1 blue, -2 violet
+    layout.add(std::make_unique<AudioParameterFloat>(EXPONENT_ID, EXPONENT_NAME, -2.0f, 2.0f, 1.0f));
+    // BAND FILTER
+    // octave or third octave band noise, see BandNoise.h; the centre snaps to the nearest band
+    // and with the per channel switch each channel takes the next band up
+    layout.add(std::make_unique<AudioParameterChoice>(BAND_ID, BAND_NAME, StringArray { "Off", "Octave", "Third Octave" }, 0));
+    NormalisableRange<float> bandCentreRange(20.0f, 20000.0f);
+    bandCentreRange.setSkewForCentre(632.0f);
+    layout.add(std::make_unique<AudioParameterFloat>(BAND_CENTRE_ID, BAND_CENTRE_NAME, bandCentreRange, 1000.0f));
+    layout.add(std::make_unique<AudioParameterBool>(BAND_SPREAD_ID, BAND_SPREAD_NAME, false));
+    // WHITE NOISE
+    // amplitude distribution, see WhiteDistribution.h; the first is the original [0, 1) noise,
+    // which sessions from before the parameter keep
+    layout.add(std::make_unique<AudioParameterChoice>(DISTRIBUTION_ID, DISTRIBUTION_NAME,
+                                                      StringArray { "Uniform 0 to 1", "Uniform", "TPDF", "Gaussian" }, 1));
+    // MIDI SYNTH
+    // plays the noise as voices from MIDI instead of continuously, see NoiseSynth.h; the
+    // envelope times are in ms
+    layout.add(std::make_unique<AudioParameterBool>(SYNTH_ID, SYNTH_NAME, false));
+    NormalisableRange<float> envelopeRange(0.0f, 5000.0f);
+    envelopeRange.setSkewForCentre(250.0f);
+    layout.add(std::make_unique<AudioParameterFloat>(ATTACK_ID, ATTACK_NAME, envelopeRange, 5.0f));
+    layout.add(std::make_unique<AudioParameterFloat>(DECAY_ID, DECAY_NAME, envelopeRange, 100.0f));
+    layout.add(std::make_unique<AudioParameterFloat>(SUSTAIN_ID, SUSTAIN_NAME, 0.0f, 1.0f, 0.7f));
+    layout.add(std::make_unique<AudioParameterFloat>(RELEASE_ID, RELEASE_NAME, envelopeRange, 200.0f));
+    // DITHER
+    // dithers and requantises the input instead of adding noise, see Dither.h
+    layout.add(std::make_unique<AudioParameterBool>(DITHER_ID, DITHER_NAME, false));
+    layout.add(std::make_unique<AudioParameterChoice>(DITHER_TYPE_ID, DITHER_TYPE_NAME, StringArray { "TPDF", "High-pass TPDF" }, 0));
+    layout.add(std::make_unique<AudioParameterChoice>(DITHER_BITS_ID, DITHER_BITS_NAME, StringArray { "8 bit", "16 bit", "20 bit", "24 bit" }, 1));
+    layout.add(std::make_unique<AudioParameterChoice>(SHAPING_ID, SHAPING_NAME,
+                                                      StringArray { "Off", "First Order", "Second Order", "E-weighted", "F-weighted" }, 0));
 
     return layout;
 }
@@ -59,11 +192,8 @@ const juce::String NoiseGeneratorPluginAudioProcessor::getName() const
 
 bool NoiseGeneratorPluginAudioProcessor::acceptsMidi() const
 {
-#if JucePlugin_WantsMidiInput
+    // the synth mode is a parameter rather than a build setting, so MIDI is always wanted
     return true;
-#else
-    return false;
-#endif
 }
 
 bool NoiseGeneratorPluginAudioProcessor::producesMidi() const
@@ -91,26 +221,66 @@ double NoiseGeneratorPluginAudioProcessor::getTailLengthSeconds() const
 
 int NoiseGeneratorPluginAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return numPrograms;
 }
 
 int NoiseGeneratorPluginAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void NoiseGeneratorPluginAudioProcessor::setCurrentProgram(int index)
 {
+    if (index < 0 || index >= numPrograms)
+        return;
+    currentProgram = index;
+
+    // processBlock switches to the whole program at its next block, and stays on the snapshot
+    // until the parameters have caught up with it; nothing waits here, timerCallback changes the
+    // parameters once no block that read them before the program was pending can still be running
+    acknowledgedProgram.store(-1);
+    pendingProgram.store(index);
 }
 
 const juce::String NoiseGeneratorPluginAudioProcessor::getProgramName(int index)
 {
-    return {};
+    if (index < 0 || index >= numPrograms)
+        return {};
+    return factoryPrograms[index].name;
 }
 
 void NoiseGeneratorPluginAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    // the factory programs keep their names
+    juce::ignoreUnused(index, newName);
+}
+
+std::vector<float> NoiseGeneratorPluginAudioProcessor::getParameterValues(const ParameterSnapshot& params) const
+{
+    // in the same order as savedParameters
+    const std::vector<float> values { params.white ? 1.0f : 0.0f, params.pink ? 1.0f : 0.0f, params.brown ? 1.0f : 0.0f,
+                             params.on ? 1.0f : 0.0f, params.dc ? 1.0f : 0.0f, params.avg ? 1.0f : 0.0f,
+                             params.level, params.dcConst, (float) params.smoothLength, params.width,
+                             params.colour ? 1.0f : 0.0f, params.grey ? 1.0f : 0.0f, params.exponent,
+                             (float) params.band, params.bandCentre, params.bandSpread ? 1.0f : 0.0f,
+                             (float) params.distribution, params.synth ? 1.0f : 0.0f,
+                             params.attack, params.decay, params.sustain, params.release,
+                             params.dither ? 1.0f : 0.0f, (float) params.ditherType, (float) params.ditherBits, (float) params.shaping };
+    jassert(savedParameters.size() == values.size());
+    return values;
+}
+
+void NoiseGeneratorPluginAudioProcessor::applyParameters(const ParameterSnapshot& params)
+{
+    const std::vector<float> values = getParameterValues(params);
+    for (size_t i = 0; i < savedParameters.size(); ++i)
+        savedParameters[i].param->setValueNotifyingHost(savedParameters[i].param->convertTo0to1(values[i]));
+}
+
+void NoiseGeneratorPluginAudioProcessor::resetParameters()
+{
+    for (const auto& saved : savedParameters)
+        saved.param->setValueNotifyingHost(saved.param->getDefaultValue());
 }
 
 //==============================================================================
@@ -118,12 +288,31 @@ void NoiseGeneratorPluginAudioProcessor::prepareToPlay(double sampleRate, int sa
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+
+    // everything processBlock touches is sized here, so the audio thread never allocates:
+    // one set of generator and filter state per channel, a smoothing history as long as
+    // the slider goes, and a chunk of scratch for each channel, in whichever precision
+    // the host is going to call processBlock with; see NoiseProcessorCore::prepare
+    // nothing depends on the block size, the noise is rendered in fixed size chunks
+    const int numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    core.prepare(sampleRate, numChannels, isUsingDoublePrecision(), isNonRealtime(), AVG_SLIDER_MAX,
+                 noiseSeed.load(), readParameters());
+    telemetry.prepare(sampleRate);
 }
 
 void NoiseGeneratorPluginAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    core.release();
+
+#if NOISE_TRACE
+    // releaseResources runs off the audio thread once playback has stopped, a good time to
+    // write out what the trace rings hold; the newest events win if it has run for a while
+    juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile("NoiseGenerator trace.json")
+        .replaceWithText(NoiseTrace::getChromeJson());
+#endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -134,9 +323,10 @@ bool NoiseGeneratorPluginAudioProcessor::isBusesLayoutSupported(const BusesLayou
     return true;
 #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets its own noise, so any layout works, named (up to 7.1.4 and beyond)
+    // or discrete, as long as it fits in the per channel state
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > MultiChannelNoise<>::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -151,10 +341,46 @@ bool NoiseGeneratorPluginAudioProcessor::isBusesLayoutSupported(const BusesLayou
 #endif
 
 void NoiseGeneratorPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void NoiseGeneratorPluginAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void NoiseGeneratorPluginAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    bypassSamples(buffer);
+}
+
+void NoiseGeneratorPluginAudioProcessor::processBlockBypassed(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    bypassSamples(buffer);
+}
+
+template <typename SampleType>
+void NoiseGeneratorPluginAudioProcessor::bypassSamples(juce::AudioBuffer<SampleType>& buffer)
+{
+    // the input passes straight through and nothing is generated; the free running position
+    // keeps counting, and the first block after the bypass seeks the noise to wherever it should be
+    for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+    noisePosition += buffer.getNumSamples();
+    core.skip(buffer.getNumSamples());
+}
+
+template <typename SampleType>
+void NoiseGeneratorPluginAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    // times the whole block, see NoiseTelemetry.h
+    const NoiseTelemetry::ScopedBlock blockTimer(telemetry, buffer.getNumSamples(), totalNumOutputChannels);
+    NOISE_TRACE_THREAD("audio");
+    NOISE_TRACE_SCOPE("processBlock");
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -167,123 +393,76 @@ void NoiseGeneratorPluginAudioProcessor::processBlock(juce::AudioBuffer<float>&
 
 
 
-    //check noise type
-    bool noiseIsWhite = treeState.getRawParameterValue(WHITE_ID)->load();
-    bool noiseIsPink  = treeState.getRawParameterValue(PINK_ID)->load();
-    bool noiseIsBrown = treeState.getRawParameterValue(BROWN_ID)->load();
-    bool dc_filter    = treeState.getRawParameterValue(DC_ID)->load();
-    bool smoothing    = treeState.getRawParameterValue(AVG_ID)->load();
-    
-    // TO DO
-    // check filter slider state changes
-    
-    // get slider values
-    float levelSliderValue = treeState.getRawParameterValue(LEVEL_ID)->load();
-//    float dcSliderValue    = treeState.getRawParameterValue(DC_SLIDER_ID)->load();
-//    int   avgSliderValue   = treeState.getRawParameterValue(AVG_SLIDER_ID)->load();
-    
-    // check slider values and update filters if changed
-//    filterWhite.setDCfiltConst(dcSliderValue);
-//    filterPink.setDCfiltConst(dcSliderValue);
-//    filterBrown.setDCfiltConst(dcSliderValue);
-//    if (avgSliderValue != smoothLength)
-//    {
-//        filterWhite.setSmoothLength(avgSliderValue);
-//        filterPink.setSmoothLength(avgSliderValue);
-//        filterBrown.setSmoothLength(avgSliderValue);
-//        smoothLength = avgSliderValue;
-//    }
-
-    // check if noise is on
-    if (treeState.getRawParameterValue(STATE_ID)->load())
-    {
-        // create a temp varaible to hold the dry signal
-        float drySig;
-        float wetSig;
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
-        {
-            auto* channelData = buffer.getWritePointer(channel);
-
-            // add noise to every sample in the buffer
-            for (int sample = 0; sample < buffer.getNumSamples(); sample++)
-            {
-                if (noiseIsWhite)
-                {
-                    // fill dry signal with current sample
-                    drySig = buffer.getSample(channel, sample);
-                    // multiply by 1 - the slider value
-                    drySig *= (1.0 - levelSliderValue);
-                    // noise source
-                    wetSig = random.nextFloat();
-                    //smoothing
-                    if (smoothing)
-                        wetSig = filterWhite.smoothing_filter(wetSig);
-                    // dc block
-                    if (dc_filter)
-                        wetSig = filterWhite.dc_blocking_filter(wetSig);
-                    // level adjust
-                    wetSig = wetSig * levelSliderValue;
-                    // add the dry and the wet to mix
-                    channelData[sample] = drySig + wetSig;
-
-                }
-                else if (noiseIsPink)
-                {
-                    // fill dry signal with current sample
-                    drySig = buffer.getSample(channel, sample);
-                    // multiply by 1 - the slider value
-                    drySig *= (1.0 - levelSliderValue);
-                    // noise source
-                    wetSig = nP.generate();
-                    // smoothing
-                    if (smoothing)
-                        wetSig = filterPink.smoothing_filter(wetSig);
-                    // dc filter
-                    if (dc_filter)
-                        wetSig = filterPink.dc_blocking_filter(wetSig);
-                    // level adjust
-                    wetSig = wetSig * levelSliderValue;
-                    // add the dry and the wet to mix
-                    channelData[sample] = drySig + wetSig;
-                }
-                else if (noiseIsBrown)
-                {
-                    // fill dry signal with current sample
-                    drySig = buffer.getSample(channel, sample);
-                    // multiply by 1 - the slider value
-                    drySig *= (1.0 - levelSliderValue);
-                    // noise source
-                    wetSig = nB.generate();
-                    // smoothing
-                    if (smoothing)
-                        wetSig = filterBrown.smoothing_filter(wetSig);
-                    // dc filter
-                    if (dc_filter)
-                        wetSig = filterBrown.dc_blocking_filter(wetSig);
-                    // level adjust
-                    wetSig = wetSig * levelSliderValue;
-                    // add the dry and the wet to mix
-                    channelData[sample] = drySig + wetSig;
-                }
-                else
-                    channelData[sample] = buffer.getSample(channel, sample); // should never happen, but here as a catch
-            }
-        }
-    }
-    // if noise is off, use the slider as a level adjust
-    else
-    {
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
-        {
-            auto* channelData = buffer.getWritePointer(channel);
+    // read every parameter once for the whole block, or take a program change's snapshot whole and
+    // let setCurrentProgram know, see there; inBlock is set before pendingProgram is read
+    inBlock.store(true);
+    const int program = pendingProgram.load();
+    if (program >= 0)
+        acknowledgedProgram.store(program);
+    const ParameterSnapshot params = program >= 0 ? programSnapshots[program] : readParameters();
 
-            // modify the volume by multiplying each sample value
-            for (int sample = 0; sample < buffer.getNumSamples(); sample++)
-            {
-                channelData[sample] = buffer.getSample(channel, sample) * levelSliderValue;
-            }
-        }
+    // the noise follows the timeline, so bouncing the same range or going round a loop
+    // always produces exactly the same samples; while playing, a jump crossfades into them
+    // over the next few blocks
+    const juce::int64 position = getBlockPosition();
+    noisePosition = position + buffer.getNumSamples();
+
+    // the dither, the synth, the noise or the level adjust, see NoiseProcessorCore::process; a
+    // silent block is cleared here, which marks the buffer as silent (hasBeenCleared()), the
+    // nearest JUCE has to a silence flag, for anything downstream that checks it
+    const int numChannels = juce::jmin(totalNumInputChannels, buffer.getNumChannels());
+    if (core.process(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples(), midiMessages,
+                     params, position, noiseSeed.load(), isNonRealtime()))
+        buffer.clear();
+
+    // the first channel for the editor's analyser, does nothing unless the editor is open
+    if (buffer.getNumChannels() > 0)
+        analyserFifo.push(buffer.getReadPointer(0), buffer.getNumSamples());
+
+    inBlock.store(false);
+}
+
+NoiseGeneratorPluginAudioProcessor::ParameterSnapshot NoiseGeneratorPluginAudioProcessor::readParameters() const
+{
+    ParameterSnapshot params;
+    params.white        = whiteParam->load()    >= 0.5f;
+    params.pink         = pinkParam->load()     >= 0.5f;
+    params.brown        = brownParam->load()    >= 0.5f;
+    params.on           = stateParam->load()    >= 0.5f;
+    params.dc           = dcParam->load()       >= 0.5f;
+    params.avg          = avgParam->load()      >= 0.5f;
+    params.level        = levelParam->load();
+    params.dcConst      = dcSliderParam->load();
+    params.smoothLength = juce::roundToInt(avgSliderParam->load());
+    params.width        = widthParam->load();
+    params.colour       = colourParam->load()   >= 0.5f;
+    params.grey         = greyParam->load()     >= 0.5f;
+    params.exponent     = exponentParam->load();
+    params.band         = juce::roundToInt(bandParam->load());
+    params.bandCentre   = bandCentreParam->load();
+    params.bandSpread   = bandSpreadParam->load() >= 0.5f;
+    params.distribution = juce::roundToInt(distributionParam->load());
+    params.synth        = synthParam->load()    >= 0.5f;
+    params.attack       = attackParam->load();
+    params.decay        = decayParam->load();
+    params.sustain      = sustainParam->load();
+    params.release      = releaseParam->load();
+    params.dither       = ditherParam->load()   >= 0.5f;
+    params.ditherType   = juce::roundToInt(ditherTypeParam->load());
+    params.ditherBits   = juce::roundToInt(ditherBitsParam->load());
+    params.shaping      = juce::roundToInt(shapingParam->load());
+    return params;
+}
+
+juce::int64 NoiseGeneratorPluginAudioProcessor::getBlockPosition()
+{
+    if (auto* playHead = getPlayHead())
+    {
+        juce::AudioPlayHead::CurrentPositionInfo info;
+        if (playHead->getCurrentPosition(info) && info.isPlaying)
+            return info.timeInSamples;
     }
+    return noisePosition;
 }
 
 //==============================================================================
@@ -300,25 +479,91 @@ juce::AudioProcessorEditor* NoiseGeneratorPluginAudioProcessor::createEditor()
 //==============================================================================
 void NoiseGeneratorPluginAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-
-    std::unique_ptr<juce::XmlElement> xml(treeState.state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // a small binary format rather than XML, so hosts that save often don't pay for building
+    // and parsing a document: the header, then each parameter's ID and value
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    stream.writeInt64((juce::int64) noiseSeed.load());
+    stream.writeInt(currentProgram);
+    stream.writeInt((int) savedParameters.size());
+    // a program timerCallback hasn't applied yet is saved as the parameters are about to be
+    const int program = pendingProgram.load();
+    const std::vector<float> programValues = program >= 0 ? getParameterValues(programSnapshots[program]) : std::vector<float>();
+    for (size_t i = 0; i < savedParameters.size(); ++i)
+    {
+        stream.writeString(savedParameters[i].id);
+        stream.writeFloat(program >= 0 ? programValues[i] : savedParameters[i].param->convertFrom0to1(savedParameters[i].param->getValue()));
+    }
 }
 
 void NoiseGeneratorPluginAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    // the state replaces any program change timerCallback hasn't finished yet
+    pendingProgram.store(-1);
+    if (readBinaryState(data, sizeInBytes))
+        return;
 
+    // sessions saved before the binary format stored the value tree as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
     // error checking
     if (xmlState != nullptr)
         if (xmlState->hasTagName(treeState.state.getType()))
+        {
+            if (xmlState->hasAttribute("noiseSeed"))
+                noiseSeed = (juce::uint64) xmlState->getStringAttribute("noiseSeed").getLargeIntValue();
+            // parameters the session didn't have yet take their defaults, as in readBinaryState
+            resetParameters();
             treeState.state = juce::ValueTree::fromXml(*xmlState);
+            // these sessions all predate the distribution, their white noise stays as it was
+            setLegacyDistribution();
+        }
+}
+
+bool NoiseGeneratorPluginAudioProcessor::readBinaryState(const void* data, int sizeInBytes)
+{
+    // magic, version, seed, program and parameter count
+    const int headerSize = 4 + 4 + 8 + 4 + 4;
+    if (data == nullptr || sizeInBytes < headerSize || (int) juce::ByteOrder::littleEndianInt(data) != stateMagic)
+        return false;
+
+    juce::MemoryInputStream stream(data, (size_t) sizeInBytes, false);
+    stream.readInt();
+    // every version so far only adds to the end, so anything from version 1 on can be read
+    if (stream.readInt() < 1)
+        return true;
+
+    noiseSeed = (juce::uint64) stream.readInt64();
+    const int program = stream.readInt();
+    if (program >= 0 && program < numPrograms)
+        currentProgram = program;
+
+    // parameters are matched by ID, and every parameter is set back to its default first, so
+    // ones that have been added since take their defaults rather than keeping whatever this
+    // instance had, and ones that have since been removed are skipped; the exception is the
+    // distribution, which a state from before it sets back to the original white noise so it
+    // sounds the same
+    resetParameters();
+    setLegacyDistribution();
+    const int numSaved = stream.readInt();
+    for (int i = 0; i < numSaved && !stream.isExhausted(); ++i)
+    {
+        const juce::String id = stream.readString();
+        const float value = stream.readFloat();
+        for (const auto& saved : savedParameters)
+            if (id == saved.id)
+                saved.param->setValueNotifyingHost(saved.param->convertTo0to1(value));
+    }
+    return true;
+}
+
+void NoiseGeneratorPluginAudioProcessor::setLegacyDistribution()
+{
+    auto* param = treeState.getParameter(DISTRIBUTION_ID);
+    param->setValueNotifyingHost(param->convertTo0to1((float) WhiteDistribution::Offset));
 }
 
 //==============================================================================
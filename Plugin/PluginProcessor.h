@@ -9,7 +9,9 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "NoiseSource.h"
+#include "NoiseProcessorCore.h"
+#include "NoiseTelemetry.h"
+#include "AnalyserFifo.h"
 // defines for consistent IDs and names
 // BUTTONS
 #define WHITE_ID    "white"
@@ -18,12 +20,22 @@
 #define PINK_NAME   "Pink Noise"
 #define BROWN_ID    "brown"
 #define BROWN_NAME  "Brown Noise"
+#define COLOUR_ID   "colour"
+#define COLOUR_NAME "Coloured Noise"
+#define GREY_ID     "grey"
+#define GREY_NAME   "Grey Noise"
 #define DC_ID       "dc"
 #define DC_NAME     "DC Blocking Filter"
 #define AVG_ID      "avg"
 #define AVG_NAME    "Moving Average Filter"
 #define STATE_ID    "state"
 #define STATE_NAME  "On/Off"
+#define BAND_SPREAD_ID   "band_spread"
+#define BAND_SPREAD_NAME "Band Per Channel"
+#define SYNTH_ID    "synth"
+#define SYNTH_NAME  "MIDI Synth"
+#define DITHER_ID   "dither"
+#define DITHER_NAME "Dither"
 // SLIDERS
 #define LEVEL_ID        "level"
 #define LEVEL_NAME      "Level"
@@ -31,11 +43,38 @@
 #define DC_SLIDER_NAME  "DC Filter Constant"
 #define AVG_SLIDER_ID   "avg_slider"
 #define AVG_SLIDER_NAME "Smooth Length"
+#define AVG_SLIDER_MAX  64
+#define WIDTH_ID        "width"
+#define WIDTH_NAME      "Width"
+#define EXPONENT_ID     "exponent"
+#define EXPONENT_NAME   "Colour Exponent"
+#define BAND_CENTRE_ID   "band_centre"
+#define BAND_CENTRE_NAME "Band Centre"
+#define ATTACK_ID       "attack"
+#define ATTACK_NAME     "Attack"
+#define DECAY_ID        "decay"
+#define DECAY_NAME      "Decay"
+#define SUSTAIN_ID      "sustain"
+#define SUSTAIN_NAME    "Sustain"
+#define RELEASE_ID      "release"
+#define RELEASE_NAME    "Release"
+// CHOICES
+#define BAND_ID     "band"
+#define BAND_NAME   "Band Filter"
+#define DISTRIBUTION_ID     "distribution"
+#define DISTRIBUTION_NAME   "White Distribution"
+#define DITHER_TYPE_ID      "dither_type"
+#define DITHER_TYPE_NAME    "Dither Type"
+#define DITHER_BITS_ID      "dither_bits"
+#define DITHER_BITS_NAME    "Dither Bit Depth"
+#define SHAPING_ID          "shaping"
+#define SHAPING_NAME        "Noise Shaping"
 
 //==============================================================================
 /**
 */
-class NoiseGeneratorPluginAudioProcessor : public juce::AudioProcessor
+class NoiseGeneratorPluginAudioProcessor : public juce::AudioProcessor,
+                                           private juce::Timer
 {
 public:
     //==============================================================================
@@ -51,6 +90,12 @@ public:
 #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    // bypass generates nothing, it only keeps the noise's position moving
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    // the noise runs natively in double when the host asks for it
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -80,20 +125,102 @@ public:
 
     //juce::AudioProcessorValueTreeState treeState;
     juce::AudioProcessorValueTreeState treeState;
+
+    // audio thread statistics for the editor's stats panel, compiled out with NOISE_TELEMETRY=0
+    NoiseTelemetry telemetry;
+    // output of the first channel for the editor's analyser, only filled while the editor reads it
+    OutputFifo analyserFifo;
     
 private:
-    // user-adjustable filter parameters
-    float dcFilterRatio = 0.99;
-    int   smoothLength = 4;
+    // every parameter value processBlock needs, read once at the start of the block, see NoiseProcessorCore.h
+    using ParameterSnapshot = NoiseParameters;
+    ParameterSnapshot readParameters() const;
+
+    // PRESETS
+    // the factory programs, see NoiseProcessorCore.h
+    static constexpr int numPrograms = numFactoryPrograms;
+    // the factory programs as the parameters will hold them, worked out once in the constructor
+    ParameterSnapshot programSnapshots[numPrograms];
+    // the program last selected, only touched by the message thread
+    int currentProgram = 0;
+    // the program selected but not yet applied to the parameters, or -1; while it is set
+    // processBlock uses that program's snapshot whole, so a block never sees half of one
+    // program and half of another
+    std::atomic<int> pendingProgram { -1 };
+    // the pending program the audio thread has taken up at the start of a block, or -1
+    std::atomic<int> acknowledgedProgram { -1 };
+    // set while processBlock runs, so timerCallback knows whether a block that read the
+    // parameters before the program was pending could still be running
+    std::atomic<bool> inBlock { false };
+    // a snapshot's values in the order of savedParameters, in the parameters' own values
+    std::vector<float> getParameterValues(const ParameterSnapshot& params) const;
+    // sets every parameter to a snapshot's values
+    void applyParameters(const ParameterSnapshot& params);
+    // sets every parameter back to its default
+    void resetParameters();
+
+    // STATE
+    // every parameter with its ID, in the order they are saved
+    struct SavedParameter
+    {
+        const char* id;
+        juce::RangedAudioParameter* param;
+    };
+    std::vector<SavedParameter> savedParameters;
+    // restores a state written by getStateInformation, false if it is not in the binary format
+    bool readBinaryState(const void* data, int sizeInBytes);
+    // sets the white noise back to the original [0, 1) distribution, for states saved before it could be chosen
+    void setLegacyDistribution();
+    // finishes program changes, and works the coloured noise's shaping filter out off the
+    // audio thread while playing
+    void timerCallback() override;
+    // the body of both processBlock overloads, hands the block to the core in its precision
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages);
+    // the body of both processBlockBypassed overloads
+    template <typename SampleType>
+    void bypassSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // raw parameter values, looked up once in the constructor so processBlock never searches by ID
+    std::atomic<float>* whiteParam    = nullptr;
+    std::atomic<float>* pinkParam     = nullptr;
+    std::atomic<float>* brownParam    = nullptr;
+    std::atomic<float>* stateParam    = nullptr;
+    std::atomic<float>* dcParam       = nullptr;
+    std::atomic<float>* avgParam      = nullptr;
+    std::atomic<float>* levelParam    = nullptr;
+    std::atomic<float>* dcSliderParam = nullptr;
+    std::atomic<float>* avgSliderParam = nullptr;
+    std::atomic<float>* widthParam    = nullptr;
+    std::atomic<float>* colourParam   = nullptr;
+    std::atomic<float>* greyParam     = nullptr;
+    std::atomic<float>* exponentParam = nullptr;
+    std::atomic<float>* bandParam     = nullptr;
+    std::atomic<float>* bandCentreParam = nullptr;
+    std::atomic<float>* bandSpreadParam = nullptr;
+    std::atomic<float>* distributionParam = nullptr;
+    std::atomic<float>* synthParam    = nullptr;
+    std::atomic<float>* attackParam   = nullptr;
+    std::atomic<float>* decayParam    = nullptr;
+    std::atomic<float>* sustainParam  = nullptr;
+    std::atomic<float>* releaseParam  = nullptr;
+    std::atomic<float>* ditherParam   = nullptr;
+    std::atomic<float>* ditherTypeParam = nullptr;
+    std::atomic<float>* ditherBitsParam = nullptr;
+    std::atomic<float>* shapingParam  = nullptr;
     
     // noise classses
-    juce::Random random;
-    PinkNoise nP;
-    BrownNoise nB;
-    NoiseFilter filterWhite, filterPink, filterBrown; // one for each noise source
-    //NoiseFilter filterWhite(dcFilterRatio, smoothLength); //, filterPink, filterBrown; // one for each noise source
-    //NoiseFilter(dcFilterRatio, smoothLength) filterWhite;
-    //NoiseFilter filterWhite(0.99, 4);
+    // the engines, the synth, the dither and everything else a block does with its audio,
+    // see NoiseProcessorCore.h, prepared in the host's precision in prepareToPlay
+    NoiseProcessorCore core;
+
+    // seed for the noise, saved with the state so a project sounds the same every time it is opened
+    std::atomic<juce::uint64> noiseSeed { WhiteNoise::makeRandomSeed() };
+    // sample position the next block is expected at, the noise is a function of this position
+    juce::int64 noisePosition = 0;
+    // the position of the current block: the host's while it is playing,
+    // otherwise carries on counting from the last block
+    juce::int64 getBlockPosition();
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoiseGeneratorPluginAudioProcessor)
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+    Created: 19 Oct 2026 8:58:02am
+    Author:  John McRae
+
+    Averaged power spectrum and triggered scope trace of a sample stream,
+    for the editor's analyser. Runs on the analyser thread, never on the
+    audio thread, so it is free to take its time.
+
+    Samples are added as they arrive. Every hopSize samples the newest
+    fftSize of them are Hann windowed and transformed with NoiseFFT,
+    and the power in each bin is averaged exponentially, so the display
+    settles to the noise's long term spectrum: flat for white, falling
+    3 dB an octave for pink and 6 dB an octave for brown.
+
+    The scope trace is the newest scopeSize samples starting at a rising
+    zero crossing when there is one, which keeps it steady on a tone and
+    just shows the latest stretch of noise otherwise.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "NoiseFFT.h"
+
+class SpectrumAnalyser {
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    // a new spectrum every half window
+    static constexpr int hopSize = fftSize / 2;
+    // bins from DC up to just below Nyquist
+    static constexpr int numBins = fftSize / 2;
+    static constexpr int scopeSize = 512;
+
+private:
+    // the newest samples, history[writePos] is the oldest
+    std::vector<float> history;
+    int writePos = 0;
+    // samples added since the last spectrum
+    int sinceLastFrame = 0;
+
+    std::vector<float> window;
+    NoiseFFT<float> fft { fftOrder };
+    std::vector<float> workRe, workIm;
+
+    // averaged power and its level in dB
+    std::vector<float> power, levelsDb;
+    std::vector<float> scope;
+    // weight of each new spectrum in the average
+    float averaging = 0.1f;
+    bool hasFrame = false;
+
+    void computeFrame() {
+        // the oldest sample is at writePos, so the window starts there
+        for (int i = 0; i < fftSize; i++) {
+            workRe[(size_t) i] = history[(size_t) ((writePos + i) & (fftSize - 1))] * window[(size_t) i];
+            workIm[(size_t) i] = 0.0f;
+        }
+        fft.perform(workRe.data(), workIm.data(), false);
+
+        // scaled so a full scale sine reads close to 0 dB: its peak bin is N / 2 for a rectangular
+        // window, halved by the Hann window's coherent gain of 0.5, so the power is (N / 4)^2
+        const float scale = 16.0f / ((float) fftSize * (float) fftSize);
+        for (int b = 0; b < numBins; b++) {
+            const float p = (workRe[(size_t) b] * workRe[(size_t) b] + workIm[(size_t) b] * workIm[(size_t) b]) * scale;
+            power[(size_t) b] = hasFrame ? power[(size_t) b] + averaging * (p - power[(size_t) b]) : p;
+            levelsDb[(size_t) b] = 10.0f * std::log10(std::max(power[(size_t) b], 1e-12f));
+        }
+
+        // scope, from the first rising zero crossing in the half window before the newest scopeSize samples
+        const int newest = writePos + fftSize;
+        int start = newest - scopeSize;
+        for (int i = newest - scopeSize - hopSize / 2; i < newest - scopeSize; i++) {
+            if (history[(size_t) (i & (fftSize - 1))] < 0.0f && history[(size_t) ((i + 1) & (fftSize - 1))] >= 0.0f) {
+                start = i + 1;
+                break;
+            }
+        }
+        for (int i = 0; i < scopeSize; i++)
+            scope[(size_t) i] = history[(size_t) ((start + i) & (fftSize - 1))];
+
+        hasFrame = true;
+    }
+
+public:
+    // sets up the window and FFT tables, allocates
+    SpectrumAnalyser()
+        : history(fftSize, 0.0f), window(fftSize), workRe(fftSize), workIm(fftSize),
+          power(numBins, 0.0f), levelsDb(numBins, -120.0f), scope(scopeSize, 0.0f) {
+        const double twoPi = 6.283185307179586;
+        for (int i = 0; i < fftSize; i++)
+            window[(size_t) i] = (float) (0.5 - 0.5 * std::cos(twoPi * i / fftSize));
+    }
+
+    // adds n samples, and returns true if a new spectrum was computed on the way
+    bool addSamples(const float* src, int n) {
+        bool newFrame = false;
+        for (int i = 0; i < n; i++) {
+            history[(size_t) writePos] = src[i];
+            writePos = (writePos + 1) & (fftSize - 1);
+            if (++sinceLastFrame >= hopSize) {
+                sinceLastFrame = 0;
+                computeFrame();
+                newFrame = true;
+            }
+        }
+        return newFrame;
+    }
+
+    // forgets the average, the next spectrum starts it again
+    void reset() { hasFrame = false; }
+
+    // 0 < weight <= 1, the share of each new spectrum in the average
+    void setAveraging(float weight) { averaging = std::max(0.001f, std::min(1.0f, weight)); }
+
+    // level of each bin in dB, bin b is centred on b * sampleRate / fftSize
+    const std::vector<float>& getLevelsDb() const { return levelsDb; }
+    const std::vector<float>& getScope() const { return scope; }
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    StatsPanel.cpp
+    Created: 18 Oct 2026 10:21:06pm
+    Author:  John McRae
+
+  ==============================================================================
+*/
+
+#include "StatsPanel.h"
+
+StatsPanel::StatsPanel(NoiseTelemetry& telemetryToShow)
+    : telemetry(telemetryToShow)
+{
+    setTooltip("Audio thread statistics, click to clear");
+    // a few times a second is plenty to read, and keeps the repaints cheap
+    startTimerHz(4);
+}
+
+StatsPanel::~StatsPanel()
+{
+    stopTimer();
+}
+
+void StatsPanel::timerCallback()
+{
+    stats = telemetry.getSnapshot();
+    repaint();
+}
+
+void StatsPanel::mouseDown(const juce::MouseEvent&)
+{
+    telemetry.reset();
+}
+
+void StatsPanel::paint(juce::Graphics& g)
+{
+    using namespace juce;
+
+    g.fillAll(Colours::black);
+    g.setColour(Colours::green);
+    g.drawRect(getLocalBounds(), 1);
+
+    auto area = getLocalBounds().reduced(4, 2);
+    auto histogramArea = area.removeFromRight(area.getWidth() / 4);
+
+    // load as a percentage of the block's budget, cost in ns per sample of one channel
+    const String loadLine = "load " + String(stats.lastLoad * 100.0, 1) + "%"
+                          + " max " + String(stats.worstLoad * 100.0, 1) + "%"
+                          + " over " + String(stats.overruns);
+    const String costLine = String(stats.meanNsPerSample, 1) + " ns/smp"
+                          + " max " + String(stats.worstNsPerSample, 1)
+                          + " sync " + String(stats.resyncs);
+
+    g.setFont(Font(9.0f));
+    g.drawText(loadLine, area.removeFromTop(area.getHeight() / 2), Justification::centredLeft, true);
+    g.drawText(costLine, area, Justification::centredLeft, true);
+
+    // one bar per power-of-two ns bucket, scaled to the busiest bucket
+    uint64_t busiest = 0;
+    for (auto count : stats.histogram)
+        busiest = jmax(busiest, count);
+    if (busiest == 0)
+        return;
+
+    const float barWidth = (float) histogramArea.getWidth() / (float) NoiseTelemetry::numBuckets;
+    for (int b = 0; b < NoiseTelemetry::numBuckets; ++b)
+    {
+        const float height = (float) histogramArea.getHeight() * (float) stats.histogram[b] / (float) busiest;
+        g.fillRect(Rectangle<float>((float) histogramArea.getX() + (float) b * barWidth,
+                                    (float) histogramArea.getBottom() - height,
+                                    jmax(1.0f, barWidth - 1.0f), height));
+    }
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    StatsPanel.h
+    Created: 18 Oct 2026 10:21:06pm
+    Author:  John McRae
+
+    Compact readout of the processor's NoiseTelemetry for the editor: the
+    load of the last and worst block, overruns, the mean and worst cost per
+    sample, play head resyncs and a small histogram of the cost per sample.
+    Clicking it clears the statistics.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "NoiseTelemetry.h"
+
+class StatsPanel : public juce::Component, public juce::SettableTooltipClient, private juce::Timer
+{
+public:
+    StatsPanel(NoiseTelemetry& telemetryToShow);
+    ~StatsPanel() override;
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+private:
+    void timerCallback() override;
+
+    NoiseTelemetry& telemetry;
+    // the statistics as of the last timer tick
+    NoiseTelemetry::Snapshot stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StatsPanel)
+};
@@ -0,0 +1,319 @@
+/*
+  ==============================================================================
+
+    WhiteDistribution.h
+    Created: 19 Oct 2026 5:21:44pm
+    Author:  John McRae
+
+    White noise of a chosen amplitude distribution, made in blocks from
+    WhiteNoise's uniform [0, 1) stream:
+
+        Offset      the uniform stream as it is, [0, 1), what the white
+                    noise has always been; its 0.5 DC is left to the DC
+                    blocker
+        Uniform     zero mean uniform, [-0.5, 0.5)
+        TPDF        triangular, the sum of two uniforms
+        Gaussian    normal, by the Ziggurat method
+
+    Every distribution but Offset has the same rms as the uniform one,
+    1 / sqrt(12), so switching changes the character of the noise and
+    not its level. The spectrum is flat for all of them.
+
+    - Position -
+
+    Like the generators, the output only depends on the seed and the
+    sample position. Sample i takes fixed uniforms from the stream: TPDF
+    samples take two each, 2i and 2i + 1, and Gaussian samples come in
+    groups of 48 from one counter group of 64 uniforms, the first 48
+    giving each sample's fraction and the last 16 three layer bytes each.
+    generate() seeks the stream itself, so WhiteNoise has to be in counter
+    mode.
+
+    - Ziggurat -
+
+    The normal density is covered by 256 layers of equal area
+    (Marsaglia and Tsang, 2000), the bottom one holding the tail beyond
+    r = 3.654. A sample picks a layer i and a point x = u x[i] across it;
+    when x < x[i + 1] it is under the curve whatever its height, which is
+    true for 98.5% of samples. The sign is the bottom bit of the
+    fraction's 24 bits, so the fast path is two table lookups, a multiply
+    and an xor, done as gathers 8 or 16 samples at a time on AVX2 and
+    AVX-512 machines and one at a time elsewhere, all giving the same
+    output. The few samples that miss are done again afterwards by the
+    exact test against the curve, or from the tail, drawing what they
+    need from WhiteNoise's side stream (see WhiteNoise::sideWords) keyed
+    by the sample's position, so they are exactly as reproducible.
+    https://www.jstatsoft.org/article/view/v005i08
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "NoiseSIMD.h"
+#include "WhiteNoise.h"
+
+enum class WhiteDistribution { Offset, Uniform, TPDF, Gaussian };
+
+class DistributedWhiteNoise {
+public:
+    // rms of every distribution but Offset, that of a uniform on [-0.5, 0.5)
+    static constexpr double rms = 0.28867513459481287;
+    // Ziggurat layers, the area of each and the start of the tail
+    static constexpr int numLayers = 256;
+    static constexpr double layerArea = 4.92867323399e-3;
+    static constexpr double tailStart = 3.6541528853610088;
+
+private:
+    struct Tables {
+        // the layers' edges x[i] scaled to the output's rms, and x[i + 1] / x[i],
+        // the share of a layer that is under the curve all the way up
+        float width[numLayers];
+        float inside[numLayers];
+        // unscaled edges and the density at each, for the slow path
+        double edge[numLayers + 1];
+        double density[numLayers + 1];
+
+        Tables() {
+            auto f = [] (double x) { return std::exp(-0.5 * x * x); };
+            // the bottom layer makes up its area with the tail
+            edge[0] = layerArea / f(tailStart);
+            edge[1] = tailStart;
+            for (int i = 1; i < numLayers - 1; i++)
+                edge[i + 1] = std::sqrt(-2.0 * std::log(layerArea / edge[i] + f(edge[i])));
+            edge[numLayers] = 0.0;
+            for (int i = 0; i <= numLayers; i++)
+                density[i] = f(edge[i]);
+            for (int i = 0; i < numLayers; i++) {
+                width[i] = (float) (edge[i] * rms);
+                inside[i] = (float) (edge[i + 1] / edge[i]);
+            }
+        }
+    };
+
+    static const Tables& getTables() {
+        static const Tables tables;
+        return tables;
+    }
+
+    // uniforms read per block
+    static constexpr int blockUniforms = 256;
+    // the Gaussian samples are made in groups of 48, from one counter group of 64 uniforms
+    static constexpr int groupUniforms = 64;
+    static constexpr int groupSamples = 48;
+    // counter blocks of WhiteNoise's side stream the slow path has for each sample,
+    // four words each, far more than it ever needs
+    static constexpr int slowBlocks = 16;
+
+    // the slow path for Gaussian sample index, whose first draw was layer and fraction u
+    static double slowGaussian(const WhiteNoise& source, uint64_t index, int layer, double u, bool negative) {
+        const Tables& t = getTables();
+        uint32_t words[4];
+        int block = 0, word = 4;
+        // uniform on (0, 1), so the logs are always finite
+        auto uniform = [&] {
+            if (word == 4) {
+                source.sideWords(index * slowBlocks + (uint64_t) block++, 1, words);
+                word = 0;
+            }
+            return ((double) words[word++] + 0.5) * (1.0 / 4294967296.0);
+        };
+        auto hasWords = [&] (int needed) { return (slowBlocks - block) * 4 + (4 - word) >= needed; };
+
+        double x = u * t.edge[layer];
+        while (hasWords(4)) {
+            if (layer == 0) {
+                // from the tail beyond r, by Marsaglia's exponential method
+                double a, b;
+                do {
+                    a = -std::log(uniform()) / tailStart;
+                    b = -std::log(uniform());
+                } while (b + b < a * a && hasWords(2));
+                x = tailStart + a;
+                break;
+            }
+            // under the curve at a random height between the layer's bottom and top
+            if (t.density[layer] + uniform() * (t.density[layer + 1] - t.density[layer]) < std::exp(-0.5 * x * x))
+                break;
+
+            // missed, a whole new draw
+            const auto bits = (uint32_t) (uniform() * 512.0);
+            layer = (int) (bits & (numLayers - 1));
+            negative = (bits & numLayers) != 0;
+            x = uniform() * t.edge[layer];
+            if (x < t.edge[layer + 1])
+                break;
+        }
+        return (negative ? -x : x) * rms;
+    }
+
+    //==============================================================================
+    // Ziggurat fast path kernels, each produces identical output: n samples (a multiple of
+    // 16) from fractions and layers into out, returning how many missed and which in missed
+
+    using FastFunction = int (*)(const float* fractions, const uint8_t* layers, const float* width,
+                                 const float* inside, float* out, int* missed, int n);
+
+    static int fastScalar(const float* fractions, const uint8_t* layers, const float* width,
+                          const float* inside, float* out, int* missed, int n) {
+        int numMissed = 0;
+        for (int s = 0; s < n; s++) {
+            const float u = fractions[s];
+            const int layer = layers[s];
+            // the bottom bit of the fraction is the sign
+            const float sign = (float) (1 - 2 * ((int32_t) (u * 16777216.0f) & 1));
+            out[s] = u * width[layer] * sign;
+            missed[numMissed] = s;
+            numMissed += u < inside[layer] ? 0 : 1;
+        }
+        return numMissed;
+    }
+
+#if NOISE_SIMD_X86
+    NOISE_TARGET_AVX2 static int fastAVX2(const float* fractions, const uint8_t* layers, const float* width,
+                                          const float* inside, float* out, int* missed, int n) {
+        const __m256 toInt = _mm256_set1_ps(16777216.0f);
+        int numMissed = 0;
+        for (int s = 0; s < n; s += 8) {
+            const __m256 u = _mm256_loadu_ps(fractions + s);
+            const __m256i layer = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (layers + s)));
+            const __m256 x = _mm256_mul_ps(u, _mm256_i32gather_ps(width, layer, 4));
+            const __m256i sign = _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(u, toInt)), 31);
+            _mm256_storeu_ps(out + s, _mm256_xor_ps(x, _mm256_castsi256_ps(sign)));
+            int mask = _mm256_movemask_ps(_mm256_cmp_ps(u, _mm256_i32gather_ps(inside, layer, 4), _CMP_NLT_UQ));
+            for (; mask != 0; mask &= mask - 1)
+                missed[numMissed++] = s + __builtin_ctz((unsigned) mask);
+        }
+        return numMissed;
+    }
+
+    NOISE_TARGET_AVX512 static int fastAVX512(const float* fractions, const uint8_t* layers, const float* width,
+                                              const float* inside, float* out, int* missed, int n) {
+        const __m512 toInt = _mm512_set1_ps(16777216.0f);
+        int numMissed = 0;
+        for (int s = 0; s < n; s += 16) {
+            const __m512 u = _mm512_loadu_ps(fractions + s);
+            const __m512i layer = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*) (layers + s)));
+            const __m512 x = _mm512_mul_ps(u, _mm512_i32gather_ps(layer, width, 4));
+            const __m512i sign = _mm512_slli_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(u, toInt)), 31);
+            _mm512_storeu_ps(out + s, _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(x), sign)));
+            unsigned mask = _mm512_cmp_ps_mask(u, _mm512_i32gather_ps(layer, inside, 4), _CMP_NLT_UQ);
+            for (; mask != 0; mask &= mask - 1)
+                missed[numMissed++] = s + __builtin_ctz(mask);
+        }
+        return numMissed;
+    }
+#endif
+
+    static FastFunction getFastFunction() {
+        static const FastFunction best = [] () -> FastFunction {
+            switch (WhiteNoise::detectIsa()) {
+#if NOISE_SIMD_X86
+                case WhiteNoise::Isa::AVX512: return fastAVX512;
+                case WhiteNoise::Isa::AVX2:   return fastAVX2;
+#endif
+                default:                      return fastScalar;
+            }
+        }();
+        return best;
+    }
+
+    template <typename SampleType>
+    static void generateGaussian(WhiteNoise& source, uint64_t position, SampleType* dst, int n) {
+        const Tables& t = getTables();
+        const FastFunction fast = getFastFunction();
+        constexpr int groupsPerBlock = blockUniforms / groupUniforms;
+        alignas(64) float uniforms[blockUniforms];
+        alignas(64) float samples[groupsPerBlock * groupSamples];
+        alignas(64) uint8_t layers[groupsPerBlock * groupSamples];
+        int missed[groupSamples];
+
+        while (n > 0) {
+            const uint64_t group = position / groupSamples;
+            const int offset = (int) (position % groupSamples);
+            const int numGroups = std::min(groupsPerBlock, (offset + n + groupSamples - 1) / groupSamples);
+            const int numSamples = std::min(n, numGroups * groupSamples - offset);
+
+            // whole counter groups, which WhiteNoise writes straight out
+            source.seek(group * groupUniforms);
+            source.generate(uniforms, numGroups * groupUniforms);
+
+            for (int g = 0; g < numGroups; g++) {
+                const float* fractions = uniforms + g * groupUniforms;
+                uint8_t* groupLayers = layers + g * groupSamples;
+                float* out = samples + g * groupSamples;
+
+                // the last 16 uniforms of the group give three samples' layers each
+                for (int q = 0; q < groupUniforms - groupSamples; q++) {
+                    const auto bits = (uint32_t) (fractions[groupSamples + q] * 16777216.0f);
+                    groupLayers[3 * q] = (uint8_t) bits;
+                    groupLayers[3 * q + 1] = (uint8_t) (bits >> 8);
+                    groupLayers[3 * q + 2] = (uint8_t) (bits >> 16);
+                }
+
+                const int numMissed = fast(fractions, groupLayers, t.width, t.inside, out, missed, groupSamples);
+                for (int m = 0; m < numMissed; m++) {
+                    const int s = missed[m];
+                    const uint64_t index = (group + (uint64_t) g) * groupSamples + (uint64_t) s;
+                    out[s] = (float) slowGaussian(source, index, groupLayers[s], fractions[s], out[s] < 0.0f);
+                }
+            }
+
+            for (int s = 0; s < numSamples; s++)
+                dst[s] = (SampleType) samples[offset + s];
+            dst += numSamples;
+            position += (uint64_t) numSamples;
+            n -= numSamples;
+        }
+    }
+
+    template <typename SampleType>
+    static void generateTPDF(WhiteNoise& source, uint64_t position, SampleType* dst, int n) {
+        alignas(64) float uniforms[blockUniforms];
+        const SampleType scale = (SampleType) std::sqrt(0.5);
+        source.seek(2 * position);
+        while (n > 0) {
+            const int count = std::min(n, blockUniforms / 2);
+            source.generate(uniforms, 2 * count);
+            for (int s = 0; s < count; s++)
+                dst[s] = ((SampleType) uniforms[2 * s] + (SampleType) uniforms[2 * s + 1] - 1) * scale;
+            dst += count;
+            n -= count;
+        }
+    }
+
+public:
+    // works the Ziggurat tables out and picks the fast path, if that hasn't been done already
+    // call it before the first Gaussian generate() on the audio thread
+    static void prepare() {
+        getTables();
+        getFastFunction();
+    }
+
+    // n samples of distribution starting at sample position, the source has to be in counter mode
+    template <typename SampleType>
+    static void generate(WhiteDistribution distribution, WhiteNoise& source, uint64_t position, SampleType* dst, int n) {
+        if (n <= 0)
+            return;
+        switch (distribution) {
+            case WhiteDistribution::Offset:
+                source.seek(position);
+                source.generate(dst, n);
+                break;
+            case WhiteDistribution::Uniform:
+                source.seek(position);
+                source.generate(dst, n);
+                for (int s = 0; s < n; s++)
+                    dst[s] -= (SampleType) 0.5;
+                break;
+            case WhiteDistribution::TPDF:
+                generateTPDF(source, position, dst, n);
+                break;
+            case WhiteDistribution::Gaussian:
+                generateGaussian(source, position, dst, n);
+                break;
+        }
+    }
+};
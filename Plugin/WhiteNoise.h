@@ -0,0 +1,687 @@
+/*
+  ==============================================================================
+
+    WhiteNoise.h
+    Created: 18 Oct 2026 9:42:10am
+    Author:  John McRae
+
+    Generates uniform white noise in [0, 1) for whole blocks at a time.
+
+    - Generator -
+
+    Runs 16 independent xoshiro128+ generators side by side, one per lane.
+    Sample i of the output stream comes from lane (i % 16), so the stream
+    is the same no matter which instruction set produced it.
+    https://prng.di.unimi.it/xoshiro128plus.c
+
+    The top 24 bits of each 32 bit result are converted to a float, which
+    gives the same [0, 1) range and resolution as juce::Random::nextFloat().
+
+    - Counter mode -
+
+    In counter mode sample i is computed directly from the seed and i with
+    Philox4x32-10, one block of four samples per counter value, instead of
+    by stepping a state. Any position in the stream can be reached at once
+    with seek(), so a render can start anywhere, be split across threads,
+    or be repeated bit for bit from the host's play head.
+
+    The stream is made of groups of 64 samples from 16 consecutive counter
+    blocks, with word w of every block stored together, so that sample i
+    is word ((i / 16) % 4) of block (i / 64) * 16 + (i % 16). The vector
+    kernels can then write each word straight out without a transpose.
+    https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+
+    - Dispatch -
+
+    The kernel is built for SSE2, AVX2 and AVX-512 on x86 and for NEON on
+    ARM, with a scalar fallback. The fastest one the CPU supports is picked
+    the first time a WhiteNoise is constructed.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "NoiseSIMD.h"
+
+class WhiteNoise {
+public:
+    // number of independent generators run side by side
+    static constexpr int numLanes = 16;
+
+    // how the stream is produced
+    enum class Mode {
+        Sequential, // xoshiro128+ lanes, the fastest
+        Counter     // Philox4x32-10, sample i depends only on the seed and i, see seek()
+    };
+
+    // instruction sets the kernel has been built for
+    enum class Isa { Scalar, SSE2, AVX2, AVX512, NEON };
+
+    // fills numSteps * numLanes floats into dst, advancing the lane state
+    using FillFunction = void (*)(uint32_t* state, float* dst, int numSteps);
+    // counter mode, fills numGroups groups of 4 * numLanes floats starting at group
+    using CounterFunction = void (*)(const uint32_t* key, uint64_t group, float* dst, int numGroups);
+
+private:
+    // generator state, laid out as s[word][lane] so that each word loads as a vector
+    alignas(64) uint32_t state[4 * numLanes];
+    // samples left over from the last kernel call, used by nextFloat() and partial blocks
+    alignas(64) float cache[numLanes];
+    // read position in the cache, numLanes when it is empty
+    int cachePos = numLanes;
+    // kernels for this CPU
+    FillFunction fill;
+    CounterFunction counterFill;
+    // which generator produces the stream
+    Mode mode = Mode::Sequential;
+    // counter mode key, taken from the seed
+    uint32_t key[2];
+    // index of the next sample in the stream
+    uint64_t position = 0;
+    // the last partly used counter mode group, so short blocks don't recompute it
+    alignas(64) float groupCache[4 * numLanes];
+    uint64_t cachedGroup = ~(uint64_t) 0;
+
+    // scale that maps the top 24 bits of a 32 bit word to [0, 1)
+    static constexpr float toFloat = 1.0f / 16777216.0f;
+
+    static uint32_t rotl (uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+    // samples in one counter mode group
+    static constexpr int groupSize = 4 * numLanes;
+
+    // counter mode generate(), whole groups go straight to the output and
+    // partial ones at either end come out of groupCache
+    void generateCounter (float* dst, int n) {
+        while (n > 0) {
+            const int offset = (int) (position % groupSize);
+            const uint64_t first = position / groupSize;
+            if (offset == 0 && n >= groupSize) {
+                const int numGroups = n / groupSize;
+                counterFill(key, first, dst, numGroups);
+                dst += numGroups * groupSize;
+                n -= numGroups * groupSize;
+                position += (uint64_t) numGroups * groupSize;
+            }
+            else {
+                const int count = std::min(n, groupSize - offset);
+                if (cachedGroup != first) {
+                    counterFill(key, first, groupCache, 1);
+                    cachedGroup = first;
+                }
+                std::memcpy(dst, groupCache + offset, sizeof(float) * (size_t) count);
+                dst += count;
+                n -= count;
+                position += (uint64_t) count;
+            }
+        }
+    }
+
+public:
+    // constructor, seeds every instance differently, like juce::Random does
+    WhiteNoise() : fill(getFillFunction()), counterFill(getCounterFunction()) { setSeed(makeRandomSeed()); }
+    // constructor with an explicit seed, two generators with the same seed produce the same stream
+    explicit WhiteNoise(uint64_t seed) : fill(getFillFunction()), counterFill(getCounterFunction()) { setSeed(seed); }
+
+    // resets the generator to the start of the stream for seed
+    void setSeed (uint64_t seed) {
+        key[0] = (uint32_t) seed;
+        key[1] = (uint32_t) (seed >> 32);
+        position = 0;
+        cachedGroup = ~(uint64_t) 0;
+        for (int lane = 0; lane < numLanes; lane++) {
+            uint64_t a = splitMix(seed), b = splitMix(seed);
+            state[0 * numLanes + lane] = (uint32_t) a;
+            state[1 * numLanes + lane] = (uint32_t) (a >> 32);
+            state[2 * numLanes + lane] = (uint32_t) b;
+            state[3 * numLanes + lane] = (uint32_t) (b >> 32);
+            // xoshiro must not be seeded with all zeros
+            if ((a | b) == 0)
+                state[lane] = 1;
+        }
+        cachePos = numLanes;
+    }
+
+    // switching mode restarts the stream from the current seed's start
+    void setMode (Mode newMode) {
+        mode = newMode;
+        setSeed((uint64_t) key[0] | ((uint64_t) key[1] << 32));
+    }
+    Mode getMode() const { return mode; }
+
+    // index of the next sample, counting from the last setSeed()
+    uint64_t getPosition() const { return position; }
+
+    // moves to sample newPosition of the stream, only possible in counter mode
+    // in sequential mode the stream can only be restarted, with setSeed()
+    void seek (uint64_t newPosition) {
+        if (mode == Mode::Counter)
+            position = newPosition;
+    }
+
+    // the sample at index in counter mode, without moving the stream
+    float valueAt (uint64_t index) const {
+        const uint64_t block = (index >> 6) * numLanes + (index % numLanes);
+        uint32_t x[4] = { (uint32_t) block, (uint32_t) (block >> 32), 0, 0 };
+        philox(x, key);
+        return (float) (x[(index / numLanes) % 4] >> 8) * toFloat;
+    }
+
+    // four random words for counter index of side stream (1 or more), from the same key as the
+    // samples but a counter they never use, for callers that sometimes need extra bits at a position
+    void sideWords (uint64_t index, uint32_t stream, uint32_t* words) const {
+        words[0] = (uint32_t) index;
+        words[1] = (uint32_t) (index >> 32);
+        words[2] = stream;
+        words[3] = 0;
+        philox(words, key);
+    }
+
+    // generates a single sample, a drop in replacement for juce::Random::nextFloat()
+    float nextFloat() {
+        if (mode == Mode::Counter) {
+            float x;
+            generateCounter(&x, 1);
+            return x;
+        }
+        position++;
+        if (cachePos == numLanes) {
+            fill(state, cache, 1);
+            cachePos = 0;
+        }
+        return cache[cachePos++];
+    }
+
+    // generates a block of n white noise samples into dst
+    void generate (float* dst, int n) {
+        if (n <= 0)
+            return;
+        if (mode == Mode::Counter) {
+            generateCounter(dst, n);
+            return;
+        }
+        position += (uint64_t) n;
+        // use up anything left in the cache first so the stream stays in order
+        while (n > 0 && cachePos < numLanes) {
+            *dst++ = cache[cachePos++];
+            n--;
+        }
+        // whole steps go straight to the output
+        const int steps = n / numLanes;
+        if (steps > 0) {
+            fill(state, dst, steps);
+            dst += steps * numLanes;
+            n -= steps * numLanes;
+        }
+        // and the tail comes out of a fresh cache
+        if (n > 0) {
+            fill(state, cache, 1);
+            std::memcpy(dst, cache, sizeof(float) * (size_t) n);
+            cachePos = n;
+        }
+    }
+
+    // the same stream widened to double, for the double precision generators
+    void generate (double* dst, int n) {
+        alignas(64) float chunk[256];
+        while (n > 0) {
+            const int count = std::min(n, 256);
+            generate(chunk, count);
+            for (int i = 0; i < count; i++)
+                dst[i] = chunk[i];
+            dst += count;
+            n -= count;
+        }
+    }
+
+    //==============================================================================
+    // kernels, each produces identical output
+
+    static void fillScalar (uint32_t* s, float* dst, int numSteps) {
+        uint32_t* s0 = s;
+        uint32_t* s1 = s + numLanes;
+        uint32_t* s2 = s + 2 * numLanes;
+        uint32_t* s3 = s + 3 * numLanes;
+        for (int step = 0; step < numSteps; step++, dst += numLanes) {
+            for (int lane = 0; lane < numLanes; lane++) {
+                const uint32_t result = s0[lane] + s3[lane];
+                const uint32_t t = s1[lane] << 9;
+                s2[lane] ^= s0[lane];
+                s3[lane] ^= s1[lane];
+                s1[lane] ^= s2[lane];
+                s0[lane] ^= s3[lane];
+                s2[lane] ^= t;
+                s3[lane] = rotl(s3[lane], 11);
+                dst[lane] = (float) (result >> 8) * toFloat;
+            }
+        }
+    }
+
+    // Philox4x32-10 applied to one counter block in place
+    static void philox (uint32_t* ctr, const uint32_t* k) {
+        uint32_t k0 = k[0], k1 = k[1];
+        for (int round = 0; round < 10; round++) {
+            const uint64_t p0 = (uint64_t) 0xD2511F53u * ctr[0];
+            const uint64_t p1 = (uint64_t) 0xCD9E8D57u * ctr[2];
+            const uint32_t c1 = ctr[1], c3 = ctr[3];
+            ctr[0] = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+            ctr[1] = (uint32_t) p1;
+            ctr[2] = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+            ctr[3] = (uint32_t) p0;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+    }
+
+    static void counterScalar (const uint32_t* k, uint64_t group, float* dst, int numGroups) {
+        for (int g = 0; g < numGroups; g++, group++, dst += groupSize) {
+            for (int b = 0; b < numLanes; b++) {
+                const uint64_t block = group * numLanes + (uint64_t) b;
+                uint32_t x[4] = { (uint32_t) block, (uint32_t) (block >> 32), 0, 0 };
+                philox(x, k);
+                for (int w = 0; w < 4; w++)
+                    dst[w * numLanes + b] = (float) (x[w] >> 8) * toFloat;
+            }
+        }
+    }
+
+#if NOISE_SIMD_X86
+    static void fillSSE2 (uint32_t* s, float* dst, int numSteps) {
+        // 4 groups of 4 lanes
+        __m128i s0[4], s1[4], s2[4], s3[4];
+        for (int g = 0; g < 4; g++) {
+            s0[g] = _mm_load_si128((const __m128i*) (s + 0 * numLanes + 4 * g));
+            s1[g] = _mm_load_si128((const __m128i*) (s + 1 * numLanes + 4 * g));
+            s2[g] = _mm_load_si128((const __m128i*) (s + 2 * numLanes + 4 * g));
+            s3[g] = _mm_load_si128((const __m128i*) (s + 3 * numLanes + 4 * g));
+        }
+        const __m128 scale = _mm_set1_ps(toFloat);
+        for (int step = 0; step < numSteps; step++, dst += numLanes) {
+            for (int g = 0; g < 4; g++) {
+                const __m128i result = _mm_add_epi32(s0[g], s3[g]);
+                const __m128i t = _mm_slli_epi32(s1[g], 9);
+                s2[g] = _mm_xor_si128(s2[g], s0[g]);
+                s3[g] = _mm_xor_si128(s3[g], s1[g]);
+                s1[g] = _mm_xor_si128(s1[g], s2[g]);
+                s0[g] = _mm_xor_si128(s0[g], s3[g]);
+                s2[g] = _mm_xor_si128(s2[g], t);
+                s3[g] = _mm_or_si128(_mm_slli_epi32(s3[g], 11), _mm_srli_epi32(s3[g], 21));
+                _mm_storeu_ps(dst + 4 * g, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), scale));
+            }
+        }
+        for (int g = 0; g < 4; g++) {
+            _mm_store_si128((__m128i*) (s + 0 * numLanes + 4 * g), s0[g]);
+            _mm_store_si128((__m128i*) (s + 1 * numLanes + 4 * g), s1[g]);
+            _mm_store_si128((__m128i*) (s + 2 * numLanes + 4 * g), s2[g]);
+            _mm_store_si128((__m128i*) (s + 3 * numLanes + 4 * g), s3[g]);
+        }
+    }
+
+    NOISE_TARGET_AVX2 static void fillAVX2 (uint32_t* s, float* dst, int numSteps) {
+        // 2 groups of 8 lanes
+        __m256i s0[2], s1[2], s2[2], s3[2];
+        for (int g = 0; g < 2; g++) {
+            s0[g] = _mm256_load_si256((const __m256i*) (s + 0 * numLanes + 8 * g));
+            s1[g] = _mm256_load_si256((const __m256i*) (s + 1 * numLanes + 8 * g));
+            s2[g] = _mm256_load_si256((const __m256i*) (s + 2 * numLanes + 8 * g));
+            s3[g] = _mm256_load_si256((const __m256i*) (s + 3 * numLanes + 8 * g));
+        }
+        const __m256 scale = _mm256_set1_ps(toFloat);
+        for (int step = 0; step < numSteps; step++, dst += numLanes) {
+            for (int g = 0; g < 2; g++) {
+                const __m256i result = _mm256_add_epi32(s0[g], s3[g]);
+                const __m256i t = _mm256_slli_epi32(s1[g], 9);
+                s2[g] = _mm256_xor_si256(s2[g], s0[g]);
+                s3[g] = _mm256_xor_si256(s3[g], s1[g]);
+                s1[g] = _mm256_xor_si256(s1[g], s2[g]);
+                s0[g] = _mm256_xor_si256(s0[g], s3[g]);
+                s2[g] = _mm256_xor_si256(s2[g], t);
+                s3[g] = _mm256_or_si256(_mm256_slli_epi32(s3[g], 11), _mm256_srli_epi32(s3[g], 21));
+                _mm256_storeu_ps(dst + 8 * g, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(result, 8)), scale));
+            }
+        }
+        for (int g = 0; g < 2; g++) {
+            _mm256_store_si256((__m256i*) (s + 0 * numLanes + 8 * g), s0[g]);
+            _mm256_store_si256((__m256i*) (s + 1 * numLanes + 8 * g), s1[g]);
+            _mm256_store_si256((__m256i*) (s + 2 * numLanes + 8 * g), s2[g]);
+            _mm256_store_si256((__m256i*) (s + 3 * numLanes + 8 * g), s3[g]);
+        }
+    }
+
+    NOISE_TARGET_AVX512 static void fillAVX512 (uint32_t* s, float* dst, int numSteps) {
+        // all 16 lanes in one register
+        __m512i s0 = _mm512_load_si512((const void*) (s + 0 * numLanes));
+        __m512i s1 = _mm512_load_si512((const void*) (s + 1 * numLanes));
+        __m512i s2 = _mm512_load_si512((const void*) (s + 2 * numLanes));
+        __m512i s3 = _mm512_load_si512((const void*) (s + 3 * numLanes));
+        const __m512 scale = _mm512_set1_ps(toFloat);
+        for (int step = 0; step < numSteps; step++, dst += numLanes) {
+            const __m512i result = _mm512_add_epi32(s0, s3);
+            const __m512i t = _mm512_slli_epi32(s1, 9);
+            s2 = _mm512_xor_si512(s2, s0);
+            s3 = _mm512_xor_si512(s3, s1);
+            s1 = _mm512_xor_si512(s1, s2);
+            s0 = _mm512_xor_si512(s0, s3);
+            s2 = _mm512_xor_si512(s2, t);
+            s3 = _mm512_rol_epi32(s3, 11);
+            _mm512_storeu_ps(dst, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(result, 8)), scale));
+        }
+        _mm512_store_si512((void*) (s + 0 * numLanes), s0);
+        _mm512_store_si512((void*) (s + 1 * numLanes), s1);
+        _mm512_store_si512((void*) (s + 2 * numLanes), s2);
+        _mm512_store_si512((void*) (s + 3 * numLanes), s3);
+    }
+    // the Philox kernels multiply the even and odd 32 bit lanes separately and
+    // put the high and low halves of the products back together with masks
+    static void counterSSE2 (const uint32_t* k, uint64_t group, float* dst, int numGroups) {
+        const __m128i m0 = _mm_set1_epi32((int) 0xD2511F53u), m1 = _mm_set1_epi32((int) 0xCD9E8D57u);
+        const __m128i evenMask = _mm_set_epi32(0, -1, 0, -1);
+        const __m128i laneOffset = _mm_set_epi32(3, 2, 1, 0);
+        const __m128 scale = _mm_set1_ps(toFloat);
+        auto mulHiLo = [evenMask] (__m128i a, __m128i m, __m128i& hi, __m128i& lo) {
+            const __m128i even = _mm_mul_epu32(a, m);
+            const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+            hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(evenMask, odd));
+            lo = _mm_or_si128(_mm_and_si128(even, evenMask), _mm_slli_epi64(odd, 32));
+        };
+        for (int g = 0; g < numGroups; g++, group++, dst += groupSize) {
+            // 4 groups of 4 blocks, the low counter word never wraps inside a group
+            const uint64_t first = group * numLanes;
+            __m128i c0[4], c1[4], c2[4], c3[4];
+            for (int q = 0; q < 4; q++) {
+                c0[q] = _mm_add_epi32(_mm_set1_epi32((int) ((uint32_t) first + 4u * (uint32_t) q)), laneOffset);
+                c1[q] = _mm_set1_epi32((int) (uint32_t) (first >> 32));
+                c2[q] = c3[q] = _mm_setzero_si128();
+            }
+            uint32_t k0 = k[0], k1 = k[1];
+            for (int round = 0; round < 10; round++) {
+                const __m128i key0 = _mm_set1_epi32((int) k0), key1 = _mm_set1_epi32((int) k1);
+                for (int q = 0; q < 4; q++) {
+                    __m128i hi0, lo0, hi1, lo1;
+                    mulHiLo(c0[q], m0, hi0, lo0);
+                    mulHiLo(c2[q], m1, hi1, lo1);
+                    c0[q] = _mm_xor_si128(_mm_xor_si128(hi1, c1[q]), key0);
+                    c1[q] = lo1;
+                    c2[q] = _mm_xor_si128(_mm_xor_si128(hi0, c3[q]), key1);
+                    c3[q] = lo0;
+                }
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            for (int q = 0; q < 4; q++) {
+                const __m128i words[4] = { c0[q], c1[q], c2[q], c3[q] };
+                for (int w = 0; w < 4; w++)
+                    _mm_storeu_ps(dst + w * numLanes + 4 * q, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(words[w], 8)), scale));
+            }
+        }
+    }
+
+    NOISE_TARGET_AVX2 static void counterAVX2 (const uint32_t* k, uint64_t group, float* dst, int numGroups) {
+        const __m256i m0 = _mm256_set1_epi32((int) 0xD2511F53u), m1 = _mm256_set1_epi32((int) 0xCD9E8D57u);
+        const __m256i evenMask = _mm256_set1_epi64x(0xffffffffLL);
+        const __m256i laneOffset = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        const __m256 scale = _mm256_set1_ps(toFloat);
+        for (int g = 0; g < numGroups; g++, group++, dst += groupSize) {
+            // 2 groups of 8 blocks
+            const uint64_t first = group * numLanes;
+            __m256i c0[2], c1[2], c2[2], c3[2];
+            for (int q = 0; q < 2; q++) {
+                c0[q] = _mm256_add_epi32(_mm256_set1_epi32((int) ((uint32_t) first + 8u * (uint32_t) q)), laneOffset);
+                c1[q] = _mm256_set1_epi32((int) (uint32_t) (first >> 32));
+                c2[q] = c3[q] = _mm256_setzero_si256();
+            }
+            uint32_t k0 = k[0], k1 = k[1];
+            for (int round = 0; round < 10; round++) {
+                const __m256i key0 = _mm256_set1_epi32((int) k0), key1 = _mm256_set1_epi32((int) k1);
+                for (int q = 0; q < 2; q++) {
+                    const __m256i even0 = _mm256_mul_epu32(c0[q], m0), odd0 = _mm256_mul_epu32(_mm256_srli_epi64(c0[q], 32), m0);
+                    const __m256i even1 = _mm256_mul_epu32(c2[q], m1), odd1 = _mm256_mul_epu32(_mm256_srli_epi64(c2[q], 32), m1);
+                    const __m256i hi0 = _mm256_or_si256(_mm256_srli_epi64(even0, 32), _mm256_andnot_si256(evenMask, odd0));
+                    const __m256i lo0 = _mm256_or_si256(_mm256_and_si256(even0, evenMask), _mm256_slli_epi64(odd0, 32));
+                    const __m256i hi1 = _mm256_or_si256(_mm256_srli_epi64(even1, 32), _mm256_andnot_si256(evenMask, odd1));
+                    const __m256i lo1 = _mm256_or_si256(_mm256_and_si256(even1, evenMask), _mm256_slli_epi64(odd1, 32));
+                    c0[q] = _mm256_xor_si256(_mm256_xor_si256(hi1, c1[q]), key0);
+                    c1[q] = lo1;
+                    c2[q] = _mm256_xor_si256(_mm256_xor_si256(hi0, c3[q]), key1);
+                    c3[q] = lo0;
+                }
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            for (int q = 0; q < 2; q++) {
+                const __m256i words[4] = { c0[q], c1[q], c2[q], c3[q] };
+                for (int w = 0; w < 4; w++)
+                    _mm256_storeu_ps(dst + w * numLanes + 8 * q, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(words[w], 8)), scale));
+            }
+        }
+    }
+
+    NOISE_TARGET_AVX512 static void counterAVX512 (const uint32_t* k, uint64_t group, float* dst, int numGroups) {
+        const __m512i m0 = _mm512_set1_epi32((int) 0xD2511F53u), m1 = _mm512_set1_epi32((int) 0xCD9E8D57u);
+        const __m512i evenMask = _mm512_set1_epi64(0xffffffffLL);
+        const __m512i laneOffset = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512 scale = _mm512_set1_ps(toFloat);
+        for (int g = 0; g < numGroups; g++, group++, dst += groupSize) {
+            // all 16 blocks in one register
+            const uint64_t first = group * numLanes;
+            __m512i c0 = _mm512_add_epi32(_mm512_set1_epi32((int) (uint32_t) first), laneOffset);
+            __m512i c1 = _mm512_set1_epi32((int) (uint32_t) (first >> 32));
+            __m512i c2 = _mm512_setzero_si512(), c3 = _mm512_setzero_si512();
+            uint32_t k0 = k[0], k1 = k[1];
+            for (int round = 0; round < 10; round++) {
+                const __m512i even0 = _mm512_mul_epu32(c0, m0), odd0 = _mm512_mul_epu32(_mm512_srli_epi64(c0, 32), m0);
+                const __m512i even1 = _mm512_mul_epu32(c2, m1), odd1 = _mm512_mul_epu32(_mm512_srli_epi64(c2, 32), m1);
+                const __m512i hi0 = _mm512_or_si512(_mm512_srli_epi64(even0, 32), _mm512_andnot_si512(evenMask, odd0));
+                const __m512i lo0 = _mm512_or_si512(_mm512_and_si512(even0, evenMask), _mm512_slli_epi64(odd0, 32));
+                const __m512i hi1 = _mm512_or_si512(_mm512_srli_epi64(even1, 32), _mm512_andnot_si512(evenMask, odd1));
+                const __m512i lo1 = _mm512_or_si512(_mm512_and_si512(even1, evenMask), _mm512_slli_epi64(odd1, 32));
+                c0 = _mm512_xor_si512(_mm512_xor_si512(hi1, c1), _mm512_set1_epi32((int) k0));
+                c1 = lo1;
+                c2 = _mm512_xor_si512(_mm512_xor_si512(hi0, c3), _mm512_set1_epi32((int) k1));
+                c3 = lo0;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            const __m512i words[4] = { c0, c1, c2, c3 };
+            for (int w = 0; w < 4; w++)
+                _mm512_storeu_ps(dst + w * numLanes, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(words[w], 8)), scale));
+        }
+    }
+#endif
+
+#if NOISE_SIMD_NEON
+    static void fillNEON (uint32_t* s, float* dst, int numSteps) {
+        // 4 groups of 4 lanes
+        uint32x4_t s0[4], s1[4], s2[4], s3[4];
+        for (int g = 0; g < 4; g++) {
+            s0[g] = vld1q_u32(s + 0 * numLanes + 4 * g);
+            s1[g] = vld1q_u32(s + 1 * numLanes + 4 * g);
+            s2[g] = vld1q_u32(s + 2 * numLanes + 4 * g);
+            s3[g] = vld1q_u32(s + 3 * numLanes + 4 * g);
+        }
+        const float32x4_t scale = vdupq_n_f32(toFloat);
+        for (int step = 0; step < numSteps; step++, dst += numLanes) {
+            for (int g = 0; g < 4; g++) {
+                const uint32x4_t result = vaddq_u32(s0[g], s3[g]);
+                const uint32x4_t t = vshlq_n_u32(s1[g], 9);
+                s2[g] = veorq_u32(s2[g], s0[g]);
+                s3[g] = veorq_u32(s3[g], s1[g]);
+                s1[g] = veorq_u32(s1[g], s2[g]);
+                s0[g] = veorq_u32(s0[g], s3[g]);
+                s2[g] = veorq_u32(s2[g], t);
+                s3[g] = vsriq_n_u32(vshlq_n_u32(s3[g], 11), s3[g], 21);
+                vst1q_f32(dst + 4 * g, vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(result, 8)), scale));
+            }
+        }
+        for (int g = 0; g < 4; g++) {
+            vst1q_u32(s + 0 * numLanes + 4 * g, s0[g]);
+            vst1q_u32(s + 1 * numLanes + 4 * g, s1[g]);
+            vst1q_u32(s + 2 * numLanes + 4 * g, s2[g]);
+            vst1q_u32(s + 3 * numLanes + 4 * g, s3[g]);
+        }
+    }
+    static void counterNEON (const uint32_t* k, uint64_t group, float* dst, int numGroups) {
+        const uint32x2_t m0 = vdup_n_u32(0xD2511F53u), m1 = vdup_n_u32(0xCD9E8D57u);
+        const uint32_t offsets[4] = { 0, 1, 2, 3 };
+        const uint32x4_t laneOffset = vld1q_u32(offsets);
+        const float32x4_t scale = vdupq_n_f32(toFloat);
+        // low and high halves of the four 64 bit products of a * m
+        auto mulHiLo = [] (uint32x4_t a, uint32x2_t m, uint32x4_t& hi, uint32x4_t& lo) {
+            const uint32x4x2_t halves = vuzpq_u32(vreinterpretq_u32_u64(vmull_u32(vget_low_u32(a), m)),
+                                                  vreinterpretq_u32_u64(vmull_u32(vget_high_u32(a), m)));
+            lo = halves.val[0];
+            hi = halves.val[1];
+        };
+        for (int g = 0; g < numGroups; g++, group++, dst += groupSize) {
+            // 4 groups of 4 blocks
+            const uint64_t first = group * numLanes;
+            uint32x4_t c0[4], c1[4], c2[4], c3[4];
+            for (int q = 0; q < 4; q++) {
+                c0[q] = vaddq_u32(vdupq_n_u32((uint32_t) first + 4 * (uint32_t) q), laneOffset);
+                c1[q] = vdupq_n_u32((uint32_t) (first >> 32));
+                c2[q] = c3[q] = vdupq_n_u32(0);
+            }
+            uint32_t k0 = k[0], k1 = k[1];
+            for (int round = 0; round < 10; round++) {
+                const uint32x4_t key0 = vdupq_n_u32(k0), key1 = vdupq_n_u32(k1);
+                for (int q = 0; q < 4; q++) {
+                    uint32x4_t hi0, lo0, hi1, lo1;
+                    mulHiLo(c0[q], m0, hi0, lo0);
+                    mulHiLo(c2[q], m1, hi1, lo1);
+                    c0[q] = veorq_u32(veorq_u32(hi1, c1[q]), key0);
+                    c1[q] = lo1;
+                    c2[q] = veorq_u32(veorq_u32(hi0, c3[q]), key1);
+                    c3[q] = lo0;
+                }
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            for (int q = 0; q < 4; q++) {
+                const uint32x4_t words[4] = { c0[q], c1[q], c2[q], c3[q] };
+                for (int w = 0; w < 4; w++)
+                    vst1q_f32(dst + w * numLanes + 4 * q, vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(words[w], 8)), scale));
+            }
+        }
+    }
+#endif
+
+    //==============================================================================
+    // runtime dispatch
+
+    // the best instruction set available on this machine
+    static Isa detectIsa() {
+#if NOISE_SIMD_X86
+ #if defined(_MSC_VER) && ! defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        const unsigned long long xcr0 = (osxsave && avx) ? _xgetbv(0) : 0;
+        if (maxLeaf >= 7 && (xcr0 & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6)
+                return Isa::AVX512;
+            if ((info[1] & (1 << 5)) != 0)
+                return Isa::AVX2;
+        }
+        return Isa::SSE2;
+ #else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return Isa::AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return Isa::AVX2;
+  #if defined(__SSE2__)
+        return Isa::SSE2;
+  #else
+        return __builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::Scalar;
+  #endif
+ #endif
+#elif NOISE_SIMD_NEON
+        return Isa::NEON;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    // the kernel for a given instruction set, falls back to scalar if it was not built
+    static FillFunction getFillFunction (Isa isa) {
+        switch (isa) {
+#if NOISE_SIMD_X86
+            case Isa::AVX512: return fillAVX512;
+            case Isa::AVX2:   return fillAVX2;
+            case Isa::SSE2:   return fillSSE2;
+#endif
+#if NOISE_SIMD_NEON
+            case Isa::NEON:   return fillNEON;
+#endif
+            default:          return fillScalar;
+        }
+    }
+
+    // the counter mode kernel for a given instruction set
+    static CounterFunction getCounterFunction (Isa isa) {
+        switch (isa) {
+#if NOISE_SIMD_X86
+            case Isa::AVX512: return counterAVX512;
+            case Isa::AVX2:   return counterAVX2;
+            case Isa::SSE2:   return counterSSE2;
+#endif
+#if NOISE_SIMD_NEON
+            case Isa::NEON:   return counterNEON;
+#endif
+            default:          return counterScalar;
+        }
+    }
+
+    // the kernels for this machine, detected once
+    static FillFunction getFillFunction() {
+        static const FillFunction best = getFillFunction(detectIsa());
+        return best;
+    }
+    static CounterFunction getCounterFunction() {
+        static const CounterFunction best = getCounterFunction(detectIsa());
+        return best;
+    }
+
+    // forces a particular kernel, mostly useful for comparing them against each other
+    // only pass an instruction set that detectIsa() says this CPU supports
+    void setIsa (Isa isa) {
+        fill = getFillFunction(isa);
+        counterFill = getCounterFunction(isa);
+    }
+
+    static const char* getIsaName (Isa isa) {
+        switch (isa) {
+            case Isa::SSE2:   return "SSE2";
+            case Isa::AVX2:   return "AVX2";
+            case Isa::AVX512: return "AVX-512";
+            case Isa::NEON:   return "NEON";
+            default:          return "scalar";
+        }
+    }
+
+    // splitmix64, steps x on and returns the next of a sequence of well mixed seeds,
+    // used to expand a single seed into the lane states, and each channel's or voice's
+    static uint64_t splitMix (uint64_t& x) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // a different seed for every call, mixes the clock with a running count
+    static uint64_t makeRandomSeed() {
+        static std::atomic<uint64_t> counter { 0 };
+        uint64_t x = (uint64_t) std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        x ^= counter.fetch_add(0x632be59bd9b4e019ULL);
+        return splitMix(x);
+    }
+};
@@ -0,0 +1,767 @@
+/*
+  ==============================================================================
+
+    NoiseBench.cpp
+    Created: 18 Oct 2026 7:12:40pm
+    Author:  John McRae
+
+    Microbenchmarks for the DSP core, built without JUCE.
+
+    Times each generator, both NoiseFilter stages, the band filter and the processor's whole
+    noise path (MultiChannelNoise::render, which is all processBlock does
+    with the audio, in single and double precision, and split over a worker
+    pool as an offline render does), the MIDI synth's voices and the
+    dither's requantisation to 16 bits, over block sizes from 1 to
+    4096 samples and channel (or voice) counts from 1 to 128. Each case is run in batches for a fixed time and
+    the fastest batch is reported, as ns/sample and, on x86, as TSC
+    cycles/sample, where a sample is one sample of one channel.
+
+    Usage:
+        NoiseBench [--json] [--filter name] [--time ms] [--quick]
+        NoiseBench --check-realtime
+
+    --json prints one JSON document, for keeping with a release and
+    comparing against later ones.
+
+    --check-realtime runs NoiseProcessorCore, the code processBlock hands
+    every block to, over every parameter combination and factory program,
+    and the synth's voices on their own, over a spread of block sizes and
+    channel counts and both precisions, under the tripwire in
+    RealtimeCheck.h, and fails if any of it allocates, frees or takes a
+    lock.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Dither.h"
+#include "MultiChannelNoise.h"
+#include "NoiseProcessorCore.h"
+#include "NoiseSynth.h"
+#include "RealtimeCheck.h"
+
+#if NOISE_SIMD_X86
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+struct BenchOptions
+{
+    bool json = false;
+    bool quick = false;
+    bool checkRealtime = false;
+    double batchTimeMs = 20.0;  // time spent on each case, split into batches
+    std::string filter;
+};
+
+struct BenchResult
+{
+    std::string name;
+    int blockSize;
+    int numChannels;
+    double nsPerSample;
+    double cyclesPerSample;     // negative when there is no cycle counter
+};
+
+// processes one block of blockSize samples for every channel
+using BlockFunction = std::function<void()>;
+// sets up the state for a case and returns the block function that runs it
+using CaseFactory = std::function<BlockFunction(int blockSize, int numChannels)>;
+
+static uint64_t readCycleCounter()
+{
+#if NOISE_SIMD_X86
+    return (uint64_t) __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// flush denormals to zero, as juce::ScopedNoDenormals does around processBlock
+static void disableDenormals()
+{
+#if NOISE_SIMD_X86
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    asm volatile("msr fpcr, %0" : : "r"(fpcr | (1 << 24)));
+#endif
+}
+
+static constexpr bool hasCycleCounter()
+{
+#if NOISE_SIMD_X86
+    return true;
+#else
+    return false;
+#endif
+}
+
+// written by consume(), volatile so the stores can't be dropped
+static volatile double benchSink = 0.0;
+
+// keeps the optimiser from dropping work whose output is never read
+template <typename SampleType>
+static void consume(const SampleType* data, int n)
+{
+    if (n > 0)
+        benchSink = (double) data[n / 2];
+}
+
+static BenchResult runCase(const std::string& name, const CaseFactory& factory,
+                           int blockSize, int numChannels, const BenchOptions& opts)
+{
+    BlockFunction block = factory(blockSize, numChannels);
+    using Clock = std::chrono::steady_clock;
+
+    // aim for batches of about a millisecond, and warm up while finding out how long that is
+    int blocksPerBatch = 1;
+    for (;;)
+    {
+        const auto start = Clock::now();
+        for (int i = 0; i < blocksPerBatch; ++i)
+            block();
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ms > 0.5 || blocksPerBatch > (1 << 24))
+            break;
+        blocksPerBatch *= 2;
+    }
+
+    double bestNs = 1e300, bestCycles = 1e300;
+    const auto caseStart = Clock::now();
+    int numBatches = 0;
+    while (numBatches < 3
+           || std::chrono::duration<double, std::milli>(Clock::now() - caseStart).count() < opts.batchTimeMs)
+    {
+        const uint64_t c0 = readCycleCounter();
+        const auto t0 = Clock::now();
+        for (int i = 0; i < blocksPerBatch; ++i)
+            block();
+        const auto t1 = Clock::now();
+        const uint64_t c1 = readCycleCounter();
+
+        const double samples = (double) blocksPerBatch * blockSize * numChannels;
+        bestNs = std::min(bestNs, std::chrono::duration<double, std::nano>(t1 - t0).count() / samples);
+        bestCycles = std::min(bestCycles, (double) (c1 - c0) / samples);
+        ++numBatches;
+    }
+
+    return { name, blockSize, numChannels, bestNs, hasCycleCounter() ? bestCycles : -1.0 };
+}
+
+//==============================================================================
+// Each case owns its state through a shared_ptr captured by the block function.
+
+// n generators of type G, one per channel, each writing its own block
+template <typename G, typename Fn>
+static CaseFactory perChannel(Fn run)
+{
+    return [run] (int blockSize, int numChannels) -> BlockFunction
+    {
+        struct State
+        {
+            std::vector<G> gens;
+            std::vector<float> buffer;
+        };
+        auto state = std::make_shared<State>();
+        for (int ch = 0; ch < numChannels; ++ch)
+            state->gens.emplace_back();
+        state->buffer.assign((size_t) blockSize * (size_t) numChannels, 0.0f);
+
+        return [state, run, blockSize, numChannels]()
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float* dst = state->buffer.data() + (size_t) ch * (size_t) blockSize;
+                run(state->gens[(size_t) ch], dst, blockSize);
+                consume(dst, blockSize);
+            }
+        };
+    };
+}
+
+// one NoiseFilter per channel running over noise that was generated up front
+template <typename Fn>
+static CaseFactory filterCase(Fn run)
+{
+    return [run] (int blockSize, int numChannels) -> BlockFunction
+    {
+        struct State
+        {
+            std::vector<NoiseFilter<>> filters;
+            std::vector<float> input, buffer;
+        };
+        auto state = std::make_shared<State>();
+        state->filters.resize((size_t) numChannels);
+        state->input.resize((size_t) blockSize * (size_t) numChannels);
+        state->buffer.resize(state->input.size());
+        WhiteNoise(1).generate(state->input.data(), (int) state->input.size());
+
+        return [state, run, blockSize, numChannels]()
+        {
+            // the copy is part of the timing, but costs far less than either filter
+            std::copy(state->input.begin(), state->input.end(), state->buffer.begin());
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float* buf = state->buffer.data() + (size_t) ch * (size_t) blockSize;
+                run(state->filters[(size_t) ch], buf, blockSize);
+                consume(buf, blockSize);
+            }
+        };
+    };
+}
+
+// BandFilterLanes over white noise, channel c on third octave band c (wrapping after 31),
+// so the whole bus is filtered in one call as MultiChannelNoise does
+static CaseFactory bandFilterCase()
+{
+    return [] (int blockSize, int numChannels) -> BlockFunction
+    {
+        struct State
+        {
+            BandFilterDesign design { 48000.0 };
+            BandFilterLanes<> filters;
+            std::vector<float> input, buffer;
+            std::vector<float*> channels;
+        };
+        auto state = std::make_shared<State>();
+        state->filters.prepare(numChannels);
+        for (int ch = 0; ch < numChannels; ++ch)
+            state->filters.setBand(ch, state->design.getBand(BandMode::ThirdOctave, ch % BandFilterDesign::numThirdOctaveBands));
+        state->input.resize((size_t) blockSize * (size_t) numChannels);
+        state->buffer.resize(state->input.size());
+        WhiteNoise(1).generate(state->input.data(), (int) state->input.size());
+        for (int ch = 0; ch < numChannels; ++ch)
+            state->channels.push_back(state->buffer.data() + (size_t) ch * (size_t) blockSize);
+
+        return [state, blockSize, numChannels]()
+        {
+            std::copy(state->input.begin(), state->input.end(), state->buffer.begin());
+            state->filters.process(state->channels.data(), numChannels, blockSize);
+            for (int ch = 0; ch < numChannels; ++ch)
+                consume(state->channels[(size_t) ch], blockSize);
+        };
+    };
+}
+
+// WhiteNoise in the counter mode MultiChannelNoise uses
+struct CounterWhiteNoise : WhiteNoise
+{
+    CounterWhiteNoise() { setMode(WhiteNoise::Mode::Counter); }
+};
+
+// counter WhiteNoise through DistributedWhiteNoise, keeping its own position
+struct DistributedWhiteState
+{
+    CounterWhiteNoise source;
+    uint64_t position = 0;
+};
+
+template <WhiteDistribution distribution>
+static CaseFactory distributedWhiteCase()
+{
+    return perChannel<DistributedWhiteState>([] (DistributedWhiteState& g, float* dst, int n)
+    {
+        DistributedWhiteNoise::generate(distribution, g.source, g.position, dst, n);
+        g.position += (uint64_t) n;
+    });
+}
+
+// ColouredNoise with every generator sharing one pink shape, as MultiChannelNoise's streams do
+struct SharedColouredNoise : ColouredNoise<>
+{
+    SharedColouredNoise()
+    {
+        static ColouredNoiseShape<> shape;
+        prepare(shape);
+        setSeed(1);
+    }
+};
+
+// the processor's noise path with both filters on, as processBlock runs it, optionally
+// with a third octave band per channel from 20 Hz, split over a pool of one thread per
+// core as it is while the host renders offline, with another white distribution, or with
+// the level, DC pole and smoothing length automated so every block ramps
+template <typename SampleType>
+static CaseFactory processBlockCase(NoiseType type, bool bands = false, bool offline = false,
+                                    WhiteDistribution distribution = WhiteDistribution::Offset, bool automated = false)
+{
+    return [type, bands, offline, distribution, automated] (int blockSize, int numChannels) -> BlockFunction
+    {
+        struct State
+        {
+            NoiseWorkers workers;
+            MultiChannelNoise<SampleType> noise;
+            ParameterRamp level { ParameterRamp::Shape::Exponential, 0.5 };
+            std::vector<SampleType> buffer;
+            std::vector<SampleType*> channels;
+            uint64_t position = 0;
+        };
+        auto state = std::make_shared<State>();
+        state->noise.prepare(numChannels);
+        state->noise.setSeed(1);
+        state->noise.setWidth(0.5f);
+        state->noise.setSampleRate(48000.0);
+        state->noise.setDistribution(distribution);
+        if (bands)
+            state->noise.setBands(BandMode::ThirdOctave, 20.0f, true);
+        if (offline)
+        {
+            state->workers.start();
+            state->noise.setWorkers(&state->workers);
+        }
+        state->buffer.assign((size_t) blockSize * (size_t) numChannels, (SampleType) 0);
+        for (int ch = 0; ch < numChannels; ++ch)
+            state->channels.push_back(state->buffer.data() + (size_t) ch * (size_t) blockSize);
+
+        return [state, type, blockSize, numChannels, automated]()
+        {
+            state->noise.seek(type, state->position, true, true);
+            if (automated)
+            {
+                const bool odd = (state->position / (uint64_t) blockSize) % 2 != 0;
+                state->level.setTarget(odd ? 0.25 : 0.75, blockSize);
+                state->noise.setDCfiltConst(odd ? 0.99f : 0.995f, blockSize);
+                state->noise.setSmoothLength(odd ? 4 : 8, blockSize);
+                state->noise.render(type, state->channels.data(), numChannels, blockSize, true, true, state->level);
+            }
+            else
+            {
+                state->noise.render(type, state->channels.data(), numChannels, blockSize, true, true, (SampleType) 0.5);
+            }
+            state->position += (uint64_t) blockSize;
+            consume(state->channels[0], blockSize);
+        };
+    };
+}
+
+// the processor's synth mode on a stereo bus with numVoices notes held, the channel count
+// being the number of voices, so the time is per voice per sample
+template <typename SampleType>
+static CaseFactory synthCase(NoiseType type)
+{
+    return [type] (int blockSize, int numVoices) -> BlockFunction
+    {
+        struct State
+        {
+            NoiseSynth<SampleType> synth;
+            std::vector<SampleType> buffer;
+            SampleType* channels[2];
+        };
+        auto state = std::make_shared<State>();
+        state->synth.setSampleRate(48000.0);
+        state->synth.setEnvelope(0.001f, 0.05f, 0.7f, 0.2f);
+        state->synth.prepare();
+        state->synth.setSeed(1);
+        for (int v = 0; v < numVoices; ++v)
+            state->synth.noteOn(1, v, 0.8f);
+        state->buffer.assign((size_t) blockSize * 2, (SampleType) 0);
+        state->channels[0] = state->buffer.data();
+        state->channels[1] = state->buffer.data() + blockSize;
+
+        return [state, type, blockSize, numVoices]()
+        {
+            state->synth.render(type, state->channels, 2, blockSize, true, true, (SampleType) 0.5);
+            consume(state->channels[0], blockSize);
+        };
+    };
+}
+
+// DitherLanes requantising white noise to 16 bits over the whole bus, as the processor's
+// dither mode does, with the given noise shaping
+template <typename SampleType>
+static CaseFactory ditherCase(NoiseShaping shaping)
+{
+    return [shaping] (int blockSize, int numChannels) -> BlockFunction
+    {
+        struct State
+        {
+            DitherLanes<SampleType> dither;
+            std::vector<float> noise;
+            std::vector<SampleType> input, buffer;
+            std::vector<SampleType*> channels;
+            uint64_t position = 0;
+        };
+        auto state = std::make_shared<State>();
+        state->dither.prepare(numChannels);
+        state->dither.setSeed(1);
+        state->dither.setBits(16);
+        state->dither.setShaping(shaping);
+        state->noise.resize((size_t) blockSize * (size_t) numChannels);
+        WhiteNoise(1).generate(state->noise.data(), (int) state->noise.size());
+        state->input.assign(state->noise.begin(), state->noise.end());
+        state->buffer.resize(state->input.size());
+        for (int ch = 0; ch < numChannels; ++ch)
+            state->channels.push_back(state->buffer.data() + (size_t) ch * (size_t) blockSize);
+
+        return [state, blockSize, numChannels]()
+        {
+            std::copy(state->input.begin(), state->input.end(), state->buffer.begin());
+            state->dither.process(state->channels.data(), numChannels, blockSize, state->position);
+            state->position += (uint64_t) blockSize;
+            for (int ch = 0; ch < numChannels; ++ch)
+                consume(state->channels[(size_t) ch], blockSize);
+        };
+    };
+}
+
+//==============================================================================
+// a MIDI event as NoiseProcessorCore reads them, the members iterating a juce::MidiBuffer gives
+struct BenchMidiEvent
+{
+    const uint8_t* data;
+    int numBytes;
+    int samplePosition;
+};
+
+// Runs NoiseProcessorCore, the code processBlock hands every block to, prepared up front as
+// prepareToPlay does and then only touched from inside the tripwire. Each case starts from
+// a factory program and changes it to one noise type, filter combination, width, colour,
+// band mode, distribution and dither setting, which the core ramps to from the case before:
+// a jump of the play head and a few blocks of noise with the level ramping, half the cases
+// playing (the colour worked out as the timer does and the jump settled in the background
+// up to its crossfade) and half rendering offline (the colour worked out in the block and
+// the jump settled at once), then a block of the dither, a block of the synth played from
+// MIDI and the level adjust, ramping, at a gain and at zero. Then every factory program is
+// played whole for a few blocks, as a program change is. Returns the number of cases run.
+template <typename SampleType>
+static int checkRealtime(int numChannels, int blockSize)
+{
+    static constexpr int maxSmoothLength = 64;
+    static constexpr double sampleRate = 48000.0;
+    const float widths[] = { 1.0f, 0.5f, 0.0f };
+    const int smoothLengths[] = { 1, 4, maxSmoothLength };
+    const float dcConsts[] = { 0.9f, 0.99f, 0.999f };
+    const float exponents[] = { 1.0f, -2.0f, 0.5f };
+    // enough blocks for the shortest ramp, 5 ms, to finish
+    const int rampBlocks = (int) (sampleRate * 0.005) / blockSize + 2;
+
+    // everything is allocated before the tripwire is armed
+    NoiseProcessorCore core;
+    core.prepare(sampleRate, numChannels, std::is_same<SampleType, double>::value, false, maxSmoothLength,
+                 1, factoryPrograms[0].params);
+    std::vector<SampleType> buffer((size_t) numChannels * (size_t) blockSize, (SampleType) 0.25);
+    std::vector<SampleType*> channels;
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels.push_back(buffer.data() + (size_t) ch * (size_t) blockSize);
+    // a note on at the start of the block and off halfway, a sysex that is skipped, and all
+    // notes off and all sound off at the end
+    const uint8_t noteOn[] = { 0x90, 60, 100 }, noteOff[] = { 0x80, 60, 0 };
+    const uint8_t allNotesOff[] = { 0xb0, 123, 0 }, allSoundOff[] = { 0xb0, 120, 0 };
+    const uint8_t sysex[] = { 0xf0, 0x7e, 0x7f, 0x06, 0x01, 0xf7 };
+    const std::vector<BenchMidiEvent> notes { { noteOn, 3, 0 }, { sysex, 6, blockSize / 4 }, { noteOff, 3, blockSize / 2 },
+                                              { allNotesOff, 3, blockSize - 1 }, { allSoundOff, 3, blockSize - 1 } };
+    const std::vector<BenchMidiEvent> noMidi;
+
+    int numCases = 0;
+    const RealtimeCheck::ScopedRealtimeCheck check;
+    for (auto type : { NoiseType::White, NoiseType::Pink, NoiseType::Brown, NoiseType::Coloured })
+    {
+        for (int filters = 0; filters < 4; ++filters)
+        {
+            for (int w = 0; w < 3; ++w)
+            {
+                NoiseParameters params = factoryPrograms[numCases % numFactoryPrograms].params;
+                params.white = type == NoiseType::White;
+                params.pink = type == NoiseType::Pink;
+                params.brown = type == NoiseType::Brown;
+                params.colour = type == NoiseType::Coloured;
+                params.on = true;
+                params.avg = (filters & 1) != 0;
+                params.dc = (filters & 2) != 0;
+                params.width = widths[w];
+                params.smoothLength = smoothLengths[w];
+                params.dcConst = dcConsts[w];
+                params.exponent = exponents[w];
+                params.grey = w == 2;
+                params.band = w;
+                params.bandCentre = 1000.0f;
+                params.bandSpread = w == 2;
+                params.distribution = numCases % 4;
+                params.synth = false;
+                params.dither = false;
+                params.ditherType = numCases % 2;
+                params.ditherBits = numCases % DitherLanes<SampleType>::numDepths;
+                params.shaping = numCases % 5;
+                const uint64_t seed = (uint64_t) numCases + 1;
+                // every other case renders offline, the rest play and have their colour worked
+                // out as the processor's timer does
+                const bool offline = numCases % 2 != 0;
+                if (! offline)
+                    core.designColour(params.exponent, params.grey);
+
+                // a jump forward, then back to the start, then playing on from there, and on
+                // for a while longer so a background settle gets to its crossfade
+                int64_t position = 1000003;
+                for (int block = 0; block < 4 || (core.isResyncing(type) && block < 64); ++block)
+                {
+                    params.level = block % 2 != 0 ? 0.0f : 0.5f;
+                    core.process(channels.data(), numChannels, blockSize, noMidi, params, position, seed, offline);
+                    position = block == 0 ? 0 : position + blockSize;
+                }
+
+                params.level = 0.5f;
+                params.dither = true;
+                core.process(channels.data(), numChannels, blockSize, noMidi, params, position, seed, offline);
+                position += blockSize;
+                params.dither = false;
+                params.synth = true;
+                core.process(channels.data(), numChannels, blockSize, notes, params, position, seed, offline);
+                position += blockSize;
+                params.synth = false;
+                params.on = false;
+                for (const float level : { 0.25f, 0.0f })
+                {
+                    params.level = level;
+                    for (int block = 0; block < rampBlocks; ++block)
+                        core.process(channels.data(), numChannels, blockSize, noMidi, params, position, seed, offline);
+                }
+                ++numCases;
+            }
+        }
+    }
+
+    for (const auto& program : factoryPrograms)
+    {
+        const bool offline = numCases % 2 != 0;
+        for (int block = 0; block < 4; ++block)
+            core.process(channels.data(), numChannels, blockSize, program.params.synth ? notes : noMidi,
+                         program.params, (int64_t) block * blockSize, 1, offline);
+        ++numCases;
+    }
+    return numCases;
+}
+
+// Runs NoiseSynth the way processBlock drives it in synth mode, prepared up front and then
+// only touched from inside the tripwire: notes on every voice and more than there are voices,
+// releases, envelope and filter changes, a reset and blocks of rendering in between, some with
+// the level and filters ramping, for every noise type and filter combination. Returns the
+// number of cases run.
+template <typename SampleType>
+static int checkSynthRealtime(int blockSize)
+{
+    static constexpr int maxSmoothLength = 64;
+    NoiseSynth<SampleType> synth;
+    synth.setSampleRate(48000.0);
+    synth.setMaxSmoothLength(maxSmoothLength);
+    synth.prepare();
+    std::vector<SampleType> buffer((size_t) 2 * (size_t) blockSize, (SampleType) 0.25);
+    SampleType* channels[] = { buffer.data(), buffer.data() + blockSize };
+    ParameterRamp level { ParameterRamp::Shape::Exponential, 0.5 };
+
+    int numCases = 0;
+    const RealtimeCheck::ScopedRealtimeCheck check;
+    for (auto type : { NoiseType::White, NoiseType::Pink, NoiseType::Brown, NoiseType::Coloured })
+    {
+        for (int filters = 0; filters < 4; ++filters)
+        {
+            const bool smooth = (filters & 1) != 0, dcBlock = (filters & 2) != 0;
+            synth.setEnvelope(0.0f, 0.001f * (float) filters, filters == 3 ? 0.0f : 0.5f, 0.002f);
+            synth.setSmoothLength(1 + filters * 20, filters % 2 != 0 ? blockSize : 0);
+            synth.setDCfiltConst(filters % 2 != 0 ? 0.995f : 0.99f, blockSize);
+            synth.setDistribution((WhiteDistribution) filters);
+            synth.setSeed((uint64_t) numCases + 1);
+
+            // a few notes, every voice, then more than every voice, and letting them all go
+            for (int step = 0; step < 5; ++step)
+            {
+                const int numNotes = step == 0 ? 3 : step == 1 ? NoiseSynth<SampleType>::maxVoices : 20;
+                for (int note = 0; note < numNotes && step < 3; ++note)
+                    synth.noteOn(1 + note % 16, note % 128, 0.5f);
+                if (step == 3)
+                    synth.noteOff(1, 0);
+                if (step == 4)
+                    synth.allNotesOff();
+                level.setTarget(step % 2 != 0 ? 0.25 : 0.5, blockSize);
+                synth.render(type, channels, 2, blockSize, smooth, dcBlock, level);
+            }
+            synth.reset();
+            synth.render(type, channels, 2, blockSize, smooth, dcBlock, (SampleType) 0.5);
+            ++numCases;
+        }
+    }
+    return numCases;
+}
+
+static int runRealtimeCheck()
+{
+    const int channelCounts[] = { 1, 2, 12, 64, 128 };
+    const int blockSizes[] = { 1, 3, 64, 441, 512, 4096 };
+
+    int numCases = 0;
+    for (int channels : channelCounts)
+    {
+        for (int blockSize : blockSizes)
+        {
+            numCases += checkRealtime<float>(channels, blockSize);
+            numCases += checkRealtime<double>(channels, blockSize);
+            if (RealtimeCheck::getViolationCount() > 0)
+            {
+                std::printf("realtime check failed: %s with %d channels, block size %d\n",
+                            RealtimeCheck::getFirstViolation(), channels, blockSize);
+                return 1;
+            }
+        }
+    }
+
+    for (int blockSize : blockSizes)
+    {
+        numCases += checkSynthRealtime<float>(blockSize);
+        numCases += checkSynthRealtime<double>(blockSize);
+        if (RealtimeCheck::getViolationCount() > 0)
+        {
+            std::printf("realtime check failed: %s in the synth, block size %d\n",
+                        RealtimeCheck::getFirstViolation(), blockSize);
+            return 1;
+        }
+    }
+
+    std::printf("realtime check passed: %d cases, no allocations, frees or locks\n", numCases);
+    return 0;
+}
+
+//==============================================================================
+static void printUsage()
+{
+    std::printf("usage: NoiseBench [--json] [--filter name] [--time ms] [--quick]\n"
+                "       NoiseBench --check-realtime\n"
+                "  --json            print the results as JSON\n"
+                "  --filter name     only run cases whose name contains name\n"
+                "  --time ms         time spent on each case (20)\n"
+                "  --quick           fewer block sizes and channel counts\n"
+                "  --check-realtime  fail if the processBlock path allocates or locks\n");
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--json")                            opts.json = true;
+        else if (arg == "--quick")                      opts.quick = true;
+        else if (arg == "--check-realtime")             opts.checkRealtime = true;
+        else if (arg == "--filter" && i + 1 < argc)     opts.filter = argv[++i];
+        else if (arg == "--time" && i + 1 < argc)       opts.batchTimeMs = std::atof(argv[++i]);
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    disableDenormals();
+
+    if (opts.checkRealtime)
+        return runRealtimeCheck();
+
+    using Type = NoiseType;
+    const std::vector<std::pair<std::string, CaseFactory>> cases =
+    {
+        { "white",            perChannel<WhiteNoise>([] (WhiteNoise& g, float* dst, int n) { g.generate(dst, n); }) },
+        { "white_counter",    perChannel<CounterWhiteNoise>([] (WhiteNoise& g, float* dst, int n) { g.generate(dst, n); }) },
+        { "white_uniform",    distributedWhiteCase<WhiteDistribution::Uniform>() },
+        { "white_tpdf",       distributedWhiteCase<WhiteDistribution::TPDF>() },
+        { "white_gaussian",   distributedWhiteCase<WhiteDistribution::Gaussian>() },
+        { "pink",             perChannel<PinkNoise<>>([] (PinkNoise<>& g, float* dst, int n) { g.generate(dst, n); }) },
+        { "brown",            perChannel<BrownNoise<>>([] (BrownNoise<>& g, float* dst, int n) { g.generate(dst, n); }) },
+        { "coloured",         perChannel<SharedColouredNoise>([] (SharedColouredNoise& g, float* dst, int n) { g.generate(dst, n); }) },
+        { "dc_filter",        filterCase([] (NoiseFilter<>& f, float* buf, int n) { f.dc_blocking_filter(buf, n); }) },
+        { "smoothing_filter", filterCase([] (NoiseFilter<>& f, float* buf, int n) { f.smoothing_filter(buf, n); }) },
+        { "band_filter",      bandFilterCase() },
+        { "process_block_white", processBlockCase<float>(Type::White) },
+        { "process_block_pink",  processBlockCase<float>(Type::Pink) },
+        { "process_block_brown", processBlockCase<float>(Type::Brown) },
+        { "process_block_coloured", processBlockCase<float>(Type::Coloured) },
+        { "process_block_pink_bands", processBlockCase<float>(Type::Pink, true) },
+        { "process_block_white_tpdf", processBlockCase<float>(Type::White, false, false, WhiteDistribution::TPDF) },
+        { "process_block_white_gaussian", processBlockCase<float>(Type::White, false, false, WhiteDistribution::Gaussian) },
+        { "process_block_white_automated", processBlockCase<float>(Type::White, false, false, WhiteDistribution::Offset, true) },
+        { "process_block_white_offline", processBlockCase<float>(Type::White, false, true) },
+        { "process_block_pink_offline",  processBlockCase<float>(Type::Pink, false, true) },
+        { "synth_white",      synthCase<float>(Type::White) },
+        { "synth_pink",       synthCase<float>(Type::Pink) },
+        { "synth_brown",      synthCase<float>(Type::Brown) },
+        { "dither_tpdf",      ditherCase<float>(NoiseShaping::Off) },
+        { "dither_fweighted", ditherCase<float>(NoiseShaping::FWeighted) },
+        { "process_block_white_double", processBlockCase<double>(Type::White) },
+        { "process_block_pink_double",  processBlockCase<double>(Type::Pink) },
+        { "process_block_brown_double", processBlockCase<double>(Type::Brown) },
+        { "process_block_coloured_double", processBlockCase<double>(Type::Coloured) },
+        { "process_block_pink_bands_double", processBlockCase<double>(Type::Pink, true) },
+    };
+
+    std::vector<int> blockSizes, channelCounts;
+    if (opts.quick)
+    {
+        blockSizes = { 1, 64, 512, 4096 };
+        channelCounts = { 1, 8, 64, 128 };
+    }
+    else
+    {
+        for (int b = 1; b <= 4096; b *= 2)
+            blockSizes.push_back(b);
+        for (int c = 1; c <= 128; c *= 2)
+            channelCounts.push_back(c);
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& c : cases)
+    {
+        if (! opts.filter.empty() && c.first.find(opts.filter) == std::string::npos)
+            continue;
+
+        for (int channels : channelCounts)
+        {
+            for (int blockSize : blockSizes)
+            {
+                results.push_back(runCase(c.first, c.second, blockSize, channels, opts));
+                const auto& r = results.back();
+                if (! opts.json)
+                {
+                    std::printf("%-26s block %5d  channels %3d  %8.3f ns/sample", r.name.c_str(), r.blockSize, r.numChannels, r.nsPerSample);
+                    if (r.cyclesPerSample >= 0)
+                        std::printf("  %8.3f cycles/sample", r.cyclesPerSample);
+                    std::printf("\n");
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+
+    if (opts.json)
+    {
+        const char* isa = WhiteNoise::getIsaName(WhiteNoise::detectIsa());
+        std::printf("{\n  \"isa\": \"%s\",\n  \"cycle_counter\": \"%s\",\n  \"results\": [\n",
+                    isa, hasCycleCounter() ? "tsc" : "none");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& r = results[i];
+            std::printf("    { \"name\": \"%s\", \"block_size\": %d, \"channels\": %d, \"ns_per_sample\": %.4f, ",
+                        r.name.c_str(), r.blockSize, r.numChannels, r.nsPerSample);
+            if (r.cyclesPerSample >= 0)
+                std::printf("\"cycles_per_sample\": %.4f }", r.cyclesPerSample);
+            else
+                std::printf("\"cycles_per_sample\": null }");
+            std::printf("%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+    return 0;
+}
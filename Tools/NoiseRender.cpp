@@ -0,0 +1,524 @@
+/*
+  ==============================================================================
+
+    NoiseRender.cpp
+    Created: 18 Oct 2026 4:36:12pm
+    Author:  John McRae
+
+    Command line renderer for long noise files, built on the generators in
+    Plugin/NoiseSource.h with no JUCE dependency.
+
+    The file is cut into fixed length segments which are rendered on every
+    core and written out in order as they complete, so memory use stays
+    bounded however long the file is. Each segment seeks its generators
+    straight to its first sample (see MultiChannelNoise::seek), even when
+    the same worker has just rendered the one before, so the file only
+    depends on the options and not on the number of threads or how the
+    segments fall to them. Without a band that is exactly what a single
+    pass from the start would produce. With one, the band filters come out
+    of each seek slightly off a single pass, see Plugin/BandNoise.h.
+
+    Usage:
+        NoiseRender -o out.wav [options]
+
+    Built with NOISE_TRACE=1 (cmake -DNOISE_TRACE=ON), --trace writes
+    the trace markers of the last part of the render as Chrome trace
+    event JSON, see Plugin/NoiseTrace.h.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MultiChannelNoise.h"
+
+//==============================================================================
+struct RenderOptions
+{
+    NoiseType type = NoiseType::White;
+    double seconds      = 10.0;
+    int    sampleRate   = 48000;
+    int    numChannels  = 1;
+    bool   smoothing    = false;
+    int    smoothLength = 4;
+    bool   dcFilter     = false;
+    float  dcConst      = 0.99f;
+    float  width        = 1.0f;
+    float  level        = 1.0f;
+    float  exponent     = 1.0f;
+    bool   grey         = false;
+    BandMode band       = BandMode::Off;
+    float  bandCentre   = 1000.0f;
+    bool   bandPerChannel = false;
+    WhiteDistribution distribution = WhiteDistribution::Offset;
+    uint64_t seed       = 1;
+    int    numThreads   = 0;    // 0 - one per core
+    bool   raw          = false;
+    enum class Sample { Float32, Int16, Int24 } sample = Sample::Float32;
+    std::string outputPath;
+    std::string tracePath;
+};
+
+// samples rendered per segment, per channel
+static constexpr int64_t segmentLength = 1 << 20;
+
+static void printUsage()
+{
+    std::printf("usage: NoiseRender -o <file> [options]\n"
+                "  --type <colour>             white, pink, brown, blue, violet, grey, or\n"
+                "                              coloured for 1/f^a with --exponent (white)\n"
+                "  --exponent <a>              slope of coloured noise, -3a dB per octave (1)\n"
+                "  --band off|octave|third     octave or third octave band noise (off)\n"
+                "  --distribution <d>          white noise offset (0 to 1), uniform, tpdf, or\n"
+                "                              gaussian (offset)\n"
+                "  --centre <hz>               the band nearest hz on every channel (1000)\n"
+                "  --spread <hz>               a band per channel, from the band nearest hz up\n"
+                "  --seconds <s>               length in seconds (10)\n"
+                "  --rate <hz>                 sample rate (48000)\n"
+                "  --channels <n>              channel count, up to %d (1)\n"
+                "  --width <0..1>              1 independent channels, 0 identical (1)\n"
+                "  --smooth <n>                enable the smoothing filter with length n\n"
+                "  --dc <r>                    enable the DC blocking filter with pole r\n"
+                "  --level <gain>              output gain (1)\n"
+                "  --seed <n>                  master seed (1)\n"
+                "  --threads <n>               worker threads, 0 for one per core (0)\n"
+                "  --format wav|raw            container, raw is headerless interleaved (wav)\n"
+                "  --sample float|int16|int24  sample format (float)\n"
+                "  --trace <file>              write a Chrome trace, needs a NOISE_TRACE build\n",
+                MultiChannelNoise<>::maxChannels);
+}
+
+static bool parseOptions(int argc, char* argv[], RenderOptions& opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        const char* value = hasValue ? argv[i + 1] : "";
+
+        if (arg == "-h" || arg == "--help")
+            return false;
+        if (! hasValue)
+        {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "-o" || arg == "--output")   opts.outputPath = value;
+        else if (arg == "--seconds")            opts.seconds = std::atof(value);
+        else if (arg == "--rate")               opts.sampleRate = std::atoi(value);
+        else if (arg == "--channels")           opts.numChannels = std::atoi(value);
+        else if (arg == "--width")              opts.width = (float) std::atof(value);
+        else if (arg == "--smooth")             { opts.smoothing = true; opts.smoothLength = std::atoi(value); }
+        else if (arg == "--dc")                 { opts.dcFilter = true; opts.dcConst = (float) std::atof(value); }
+        else if (arg == "--level")              opts.level = (float) std::atof(value);
+        else if (arg == "--seed")               opts.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--threads")            opts.numThreads = std::atoi(value);
+        else if (arg == "--trace")              opts.tracePath = value;
+        else if (arg == "--exponent")           opts.exponent = (float) std::atof(value);
+        else if (arg == "--centre")             { opts.bandCentre = (float) std::atof(value); opts.bandPerChannel = false; }
+        else if (arg == "--spread")             { opts.bandCentre = (float) std::atof(value); opts.bandPerChannel = true; }
+        else if (arg == "--band")
+        {
+            const std::string v = value;
+            if (v == "off")         opts.band = BandMode::Off;
+            else if (v == "octave") opts.band = BandMode::Octave;
+            else if (v == "third")  opts.band = BandMode::ThirdOctave;
+            else { std::fprintf(stderr, "unknown band %s\n", value); return false; }
+        }
+        else if (arg == "--distribution")
+        {
+            const std::string v = value;
+            if (v == "offset")          opts.distribution = WhiteDistribution::Offset;
+            else if (v == "uniform")    opts.distribution = WhiteDistribution::Uniform;
+            else if (v == "tpdf")       opts.distribution = WhiteDistribution::TPDF;
+            else if (v == "gaussian")   opts.distribution = WhiteDistribution::Gaussian;
+            else { std::fprintf(stderr, "unknown distribution %s\n", value); return false; }
+        }
+        else if (arg == "--type")
+        {
+            const std::string v = value;
+            if (v == "white")       opts.type = NoiseType::White;
+            else if (v == "pink")   opts.type = NoiseType::Pink;
+            else if (v == "brown")  opts.type = NoiseType::Brown;
+            else if (v == "coloured")   opts.type = NoiseType::Coloured;
+            else if (v == "blue")   { opts.type = NoiseType::Coloured; opts.exponent = -1.0f; }
+            else if (v == "violet") { opts.type = NoiseType::Coloured; opts.exponent = -2.0f; }
+            else if (v == "grey")   { opts.type = NoiseType::Coloured; opts.grey = true; }
+            else { std::fprintf(stderr, "unknown noise type %s\n", value); return false; }
+        }
+        else if (arg == "--format")
+        {
+            const std::string v = value;
+            if (v == "wav")         opts.raw = false;
+            else if (v == "raw")    opts.raw = true;
+            else { std::fprintf(stderr, "unknown format %s\n", value); return false; }
+        }
+        else if (arg == "--sample")
+        {
+            const std::string v = value;
+            if (v == "float")       opts.sample = RenderOptions::Sample::Float32;
+            else if (v == "int16")  opts.sample = RenderOptions::Sample::Int16;
+            else if (v == "int24")  opts.sample = RenderOptions::Sample::Int24;
+            else { std::fprintf(stderr, "unknown sample format %s\n", value); return false; }
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opts.outputPath.empty() || opts.seconds <= 0 || opts.sampleRate <= 0
+        || opts.numChannels < 1 || opts.numChannels > MultiChannelNoise<>::maxChannels
+        || opts.smoothLength < 1 || opts.dcConst >= 1.0f)
+    {
+        std::fprintf(stderr, "invalid options\n");
+        return false;
+    }
+    return true;
+}
+
+//==============================================================================
+// Streams interleaved float samples to a WAV (RF64 past 4 GB) or raw file.
+// The total length is known up front, so the header is written once at the start.
+class NoiseFileWriter
+{
+public:
+    NoiseFileWriter(const RenderOptions& o, int64_t totalFrames) : opts(o)
+    {
+        file = std::fopen(opts.outputPath.c_str(), "wb");
+        if (file != nullptr && ! opts.raw)
+            writeHeader(totalFrames);
+    }
+
+    ~NoiseFileWriter()
+    {
+        if (file != nullptr)
+        {
+            if (! opts.raw && (bytesWritten & 1) != 0)
+                std::fputc(0, file);
+            std::fclose(file);
+        }
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    int getBytesPerSample() const
+    {
+        return opts.sample == RenderOptions::Sample::Int16 ? 2 : (opts.sample == RenderOptions::Sample::Int24 ? 3 : 4);
+    }
+
+    // converts and writes numSamples interleaved samples
+    bool write(const float* data, size_t numSamples)
+    {
+        const int bytesPerSample = getBytesPerSample();
+        bytes.resize(numSamples * (size_t) bytesPerSample);
+        uint8_t* out = bytes.data();
+
+        switch (opts.sample)
+        {
+            case RenderOptions::Sample::Float32:
+                for (size_t i = 0; i < numSamples; ++i, out += 4)
+                    putLE(out, floatBits(data[i]), 4);
+                break;
+            case RenderOptions::Sample::Int16:
+                for (size_t i = 0; i < numSamples; ++i, out += 2)
+                    putLE(out, (uint32_t) toInt(data[i], 32767.0f), 2);
+                break;
+            case RenderOptions::Sample::Int24:
+                for (size_t i = 0; i < numSamples; ++i, out += 3)
+                    putLE(out, (uint32_t) toInt(data[i], 8388607.0f), 3);
+                break;
+        }
+
+        bytesWritten += bytes.size();
+        return std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    }
+
+private:
+    const RenderOptions& opts;
+    FILE* file = nullptr;
+    std::vector<uint8_t> bytes;
+    uint64_t bytesWritten = 0;
+
+    static void putLE(uint8_t* p, uint64_t v, int numBytes)
+    {
+        for (int i = 0; i < numBytes; ++i)
+            p[i] = (uint8_t) (v >> (8 * i));
+    }
+
+    static uint32_t floatBits(float f)
+    {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static int32_t toInt(float x, float fullScale)
+    {
+        const float y = std::max(-1.0f, std::min(1.0f, x)) * fullScale;
+        return (int32_t) std::lrint(y);
+    }
+
+    void writeHeader(int64_t totalFrames)
+    {
+        const int bytesPerSample = getBytesPerSample();
+        const uint64_t blockAlign = (uint64_t) opts.numChannels * (uint64_t) bytesPerSample;
+        const uint64_t dataBytes = (uint64_t) totalFrames * blockAlign;
+        const bool isFloat = opts.sample == RenderOptions::Sample::Float32;
+        // WAVE_FORMAT_EXTENSIBLE, needed for more than two channels or 24 bit
+        const uint32_t fmtSize = 40;
+        // chunks are padded to an even length
+        const uint64_t riffSize = 4 + (8 + fmtSize) + 8 + dataBytes + (dataBytes & 1);
+        const bool rf64 = riffSize > 0xffffffffULL;
+
+        std::vector<uint8_t> h;
+        auto add = [&h](uint64_t v, int n) { for (int i = 0; i < n; ++i) h.push_back((uint8_t) (v >> (8 * i))); };
+        auto tag = [&h](const char* t) { h.insert(h.end(), t, t + 4); };
+
+        tag(rf64 ? "RF64" : "RIFF");
+        add(rf64 ? 0xffffffffULL : riffSize, 4);
+        tag("WAVE");
+
+        if (rf64)
+        {
+            // ds64 holds the real 64 bit sizes
+            tag("ds64");
+            add(28, 4);
+            add(riffSize + 36, 8);
+            add(dataBytes, 8);
+            add((uint64_t) totalFrames, 8);
+            add(0, 4);
+        }
+
+        tag("fmt ");
+        add(fmtSize, 4);
+        add(0xfffe, 2);                                         // WAVE_FORMAT_EXTENSIBLE
+        add((uint64_t) opts.numChannels, 2);
+        add((uint64_t) opts.sampleRate, 4);
+        add((uint64_t) opts.sampleRate * blockAlign, 4);
+        add(blockAlign, 2);
+        add((uint64_t) bytesPerSample * 8, 2);
+        add(22, 2);                                             // extension size
+        add((uint64_t) bytesPerSample * 8, 2);                  // valid bits
+        add(0, 4);                                              // channel mask, unassigned
+        add(isFloat ? 3 : 1, 2);                                // subformat GUID
+        const uint8_t guidTail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+        h.insert(h.end(), guidTail, guidTail + 14);
+
+        tag("data");
+        add(rf64 ? 0xffffffffULL : dataBytes, 4);
+
+        std::fwrite(h.data(), 1, h.size(), file);
+    }
+};
+
+//==============================================================================
+// Renders one segment as interleaved samples.
+class SegmentRenderer
+{
+public:
+    explicit SegmentRenderer(const RenderOptions& o)
+        : opts(o), noise(o.numChannels)
+    {
+        noise.setSeed(opts.seed);
+        noise.setWidth(opts.width);
+        noise.setMaxSmoothLength(opts.smoothLength);
+        noise.setSmoothLength(opts.smoothLength);
+        noise.setDCfiltConst(opts.dcConst);
+        noise.setSampleRate(opts.sampleRate);
+        noise.setColour(opts.exponent, opts.grey);
+        noise.setBands(opts.band, opts.bandCentre, opts.bandPerChannel);
+        noise.setDistribution(opts.distribution);
+
+        planar.resize((size_t) opts.numChannels * MultiChannelNoise<>::chunkSize);
+        channels.resize((size_t) opts.numChannels);
+        for (int ch = 0; ch < opts.numChannels; ++ch)
+            channels[(size_t) ch] = planar.data() + (size_t) ch * MultiChannelNoise<>::chunkSize;
+    }
+
+    // renders numFrames frames starting at frame first into dst, interleaved
+    void render(int64_t first, float* dst, int64_t numFrames)
+    {
+        // a worker that rendered the segment before would carry on from it, which the band
+        // filters don't do bit-exactly with a seek, so it settles again instead and each
+        // segment comes out the same whichever worker renders it
+        if (noise.getPosition(opts.type) == (uint64_t) first)
+            noise.resettle(opts.type, opts.smoothing, opts.dcFilter);
+        else
+            noise.seek(opts.type, (uint64_t) first, opts.smoothing, opts.dcFilter);
+
+        for (int64_t done = 0; done < numFrames; done += MultiChannelNoise<>::chunkSize)
+        {
+            const int n = (int) std::min<int64_t>(MultiChannelNoise<>::chunkSize, numFrames - done);
+            renderChunk(dst + done * opts.numChannels, n);
+        }
+    }
+
+private:
+    const RenderOptions& opts;
+    MultiChannelNoise<> noise;
+    std::vector<float> planar;
+    std::vector<float*> channels;
+
+    void renderChunk(float* dst, int n)
+    {
+        const int numChannels = opts.numChannels;
+        noise.generate(opts.type, channels.data(), numChannels, n);
+        noise.process(opts.type, channels.data(), numChannels, n, opts.smoothing, opts.dcFilter);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* src = channels[(size_t) ch];
+            for (int s = 0; s < n; ++s)
+                dst[s * numChannels + ch] = src[s] * opts.level;
+        }
+    }
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    RenderOptions opts;
+    if (! parseOptions(argc, argv, opts))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const int64_t totalFrames = (int64_t) std::llround(opts.seconds * opts.sampleRate);
+    const int64_t numSegments = (totalFrames + segmentLength - 1) / segmentLength;
+    const int numThreads = opts.numThreads > 0 ? opts.numThreads
+                                               : (int) std::max(1u, std::thread::hardware_concurrency());
+    // segments rendered but not yet written, bounds the memory in use
+    const int64_t maxInFlight = 2 * (int64_t) numThreads;
+
+    NoiseFileWriter writer(opts, totalFrames);
+    if (! writer.isOpen())
+    {
+        std::fprintf(stderr, "could not open %s\n", opts.outputPath.c_str());
+        return 1;
+    }
+
+    // one slot per segment in flight, segment i uses slot i % maxInFlight
+    struct Slot
+    {
+        std::vector<float> samples;
+        int64_t index = -1;
+        bool ready = false;
+    };
+    std::vector<Slot> slots((size_t) maxInFlight);
+    std::mutex lock;
+    std::condition_variable slotReady, slotFree;
+    std::atomic<int64_t> nextSegment { 0 };
+    int64_t nextToWrite = 0;
+
+    auto worker = [&]()
+    {
+        NOISE_TRACE_THREAD("render worker");
+        SegmentRenderer renderer(opts);
+
+        for (;;)
+        {
+            const int64_t index = nextSegment.fetch_add(1);
+            if (index >= numSegments)
+                return;
+
+            Slot& slot = slots[(size_t) (index % maxInFlight)];
+            {
+                // wait for the writer to finish with this slot's previous segment
+                std::unique_lock<std::mutex> l(lock);
+                slotFree.wait(l, [&] { return index < nextToWrite + maxInFlight; });
+            }
+
+            const int64_t first = index * segmentLength;
+            const int64_t frames = std::min(segmentLength, totalFrames - first);
+            slot.samples.resize((size_t) frames * (size_t) opts.numChannels);
+            {
+                NOISE_TRACE_SCOPE("segment");
+                renderer.render(first, slot.samples.data(), frames);
+            }
+
+            {
+                std::lock_guard<std::mutex> l(lock);
+                slot.index = index;
+                slot.ready = true;
+            }
+            slotReady.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+        threads.emplace_back(worker);
+
+    NOISE_TRACE_THREAD("writer");
+    bool ok = true;
+    for (int64_t index = 0; index < numSegments && ok; ++index)
+    {
+        Slot& slot = slots[(size_t) (index % maxInFlight)];
+        {
+            std::unique_lock<std::mutex> l(lock);
+            slotReady.wait(l, [&] { return slot.ready && slot.index == index; });
+        }
+
+        {
+            NOISE_TRACE_SCOPE("write");
+            ok = writer.write(slot.samples.data(), slot.samples.size());
+        }
+
+        {
+            std::lock_guard<std::mutex> l(lock);
+            slot.ready = false;
+            ++nextToWrite;
+        }
+        slotFree.notify_all();
+    }
+
+    if (! ok)
+    {
+        // let the workers run out of segments, then report the failure
+        nextSegment = numSegments;
+        {
+            std::lock_guard<std::mutex> l(lock);
+            nextToWrite = numSegments + maxInFlight;
+        }
+        slotFree.notify_all();
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    if (! ok)
+    {
+        std::fprintf(stderr, "error writing %s\n", opts.outputPath.c_str());
+        return 1;
+    }
+
+    if (! opts.tracePath.empty())
+    {
+       #if NOISE_TRACE
+        if (! NoiseTrace::writeChromeJson(opts.tracePath.c_str()))
+        {
+            std::fprintf(stderr, "error writing %s\n", opts.tracePath.c_str());
+            return 1;
+        }
+       #else
+        std::fprintf(stderr, "no trace written, NoiseRender was built without NOISE_TRACE\n");
+       #endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Created: 18 Oct 2026 9:04:17pm
+    Author:  John McRae
+
+    The replacement allocation and lock functions behind RealtimeCheck.h.
+
+    With glibc the C allocation functions are replaced and forward to
+    glibc's own, which catches operator new, the C++ runtime and anything
+    else that allocates. Elsewhere only the global operator new and delete
+    can be replaced portably, which still covers the standard containers.
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    // only a plain int, so reading it never needs the thread_local to be constructed,
+    // which matters when malloc is called while a thread is still being set up
+    thread_local int armedDepth = 0;
+    std::atomic<long> violations { 0 };
+    std::atomic<const char*> firstViolation { nullptr };
+
+    void trip(const char* what)
+    {
+        if (armedDepth == 0)
+            return;
+
+        violations.fetch_add(1, std::memory_order_relaxed);
+        const char* none = nullptr;
+        firstViolation.compare_exchange_strong(none, what);
+    }
+}
+
+namespace RealtimeCheck
+{
+    long getViolationCount()            { return violations.load(); }
+    const char* getFirstViolation()     { return firstViolation.load(); }
+
+    ScopedRealtimeCheck::ScopedRealtimeCheck()  { ++armedDepth; }
+    ScopedRealtimeCheck::~ScopedRealtimeCheck() { --armedDepth; }
+}
+
+#if defined(__GLIBC__)
+//==============================================================================
+// glibc exports its allocator under these names as well, so the replacements can forward to it
+extern "C"
+{
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void  __libc_free(void*);
+}
+
+namespace
+{
+    using MutexLockFunction = int (*)(pthread_mutex_t*);
+
+    // the real pthread_mutex_lock, looked up during static initialisation
+    // so the lookup itself can never happen inside a check
+    MutexLockFunction findMutexLock()
+    {
+        return reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    }
+    const MutexLockFunction realMutexLock = findMutexLock();
+}
+
+extern "C"
+{
+    void* malloc(std::size_t size) noexcept
+    {
+        trip("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept
+    {
+        trip("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, std::size_t size) noexcept
+    {
+        trip("realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(std::size_t alignment, std::size_t size) noexcept
+    {
+        trip("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+    {
+        trip("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) noexcept
+    {
+        trip("posix_memalign");
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        void* p = __libc_memalign(alignment, size);
+        if (p == nullptr)
+            return ENOMEM;
+        *ptr = p;
+        return 0;
+    }
+
+    void free(void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            trip("free");
+        __libc_free(ptr);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        trip("pthread_mutex_lock");
+        // a lock taken before static initialisation has got this far is single threaded
+        return realMutexLock != nullptr ? realMutexLock(mutex) : findMutexLock()(mutex);
+    }
+}
+
+#else
+//==============================================================================
+namespace
+{
+    void* allocate(std::size_t size, const char* what)
+    {
+        trip(what);
+        if (void* p = std::malloc(size > 0 ? size : 1))
+            return p;
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment, const char* what)
+    {
+        trip(what);
+        const auto align = static_cast<std::size_t>(alignment);
+        size = (size + align - 1) / align * align;
+       #if defined(_MSC_VER)
+        void* p = _aligned_malloc(size > 0 ? size : align, align);
+       #else
+        void* p = std::aligned_alloc(align, size > 0 ? size : align);
+       #endif
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void deallocate(void* ptr)
+    {
+        if (ptr != nullptr)
+            trip("operator delete");
+        std::free(ptr);
+    }
+
+    void deallocateAligned(void* ptr)
+    {
+        if (ptr != nullptr)
+            trip("operator delete");
+       #if defined(_MSC_VER)
+        _aligned_free(ptr);
+       #else
+        std::free(ptr);
+       #endif
+    }
+}
+
+void* operator new(std::size_t size)                                        { return allocate(size, "operator new"); }
+void* operator new[](std::size_t size)                                      { return allocate(size, "operator new[]"); }
+void* operator new(std::size_t size, std::align_val_t alignment)            { return allocateAligned(size, alignment, "operator new"); }
+void* operator new[](std::size_t size, std::align_val_t alignment)          { return allocateAligned(size, alignment, "operator new[]"); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size, "operator new"); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size, "operator new[]"); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept                                    { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept                                  { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                       { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept                     { deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept             { deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept           { deallocate(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept                  { deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                { deallocateAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept     { deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept   { deallocateAligned(ptr); }
+#endif
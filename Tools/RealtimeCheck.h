@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    Created: 18 Oct 2026 9:04:17pm
+    Author:  John McRae
+
+    Allocation and lock tripwire for the command line tools.
+
+    Linking RealtimeCheck.cpp into a program replaces the global allocation
+    functions (malloc and friends and pthread_mutex_lock with glibc, the
+    global operator new and delete elsewhere). While a ScopedRealtimeCheck
+    is alive on a thread, every call that thread makes into them is
+    counted as a violation, so code that has to be real-time safe, like
+    everything processBlock runs, can be run under it and checked.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace RealtimeCheck
+{
+    // allocations, frees and locks seen inside a ScopedRealtimeCheck so far
+    long getViolationCount();
+    // the kind of call that was the first violation, or nullptr if there has not been one
+    const char* getFirstViolation();
+
+    // arms the tripwire on the calling thread for as long as it is alive
+    struct ScopedRealtimeCheck
+    {
+        ScopedRealtimeCheck();
+        ~ScopedRealtimeCheck();
+
+        ScopedRealtimeCheck(const ScopedRealtimeCheck&) = delete;
+        ScopedRealtimeCheck& operator=(const ScopedRealtimeCheck&) = delete;
+    };
+}